@@ -1,92 +1,191 @@
 #include <cmath>
+#include <iostream>
 #include "LlyodCentralisation.hpp"
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-void Graphe::triesNearCellulePoints() // Sort the near cell points based on their distance to the current energy point
+template<typename Precision>
+typename BasicGraphe<Precision>::CellMoments BasicGraphe<Precision>::computeCellMoments(int idxPoint) const
 {
-    if (nearCellulePoints.empty())
+    const Real pointX = pointList.x[idxPoint];
+    const Real pointY = pointList.y[idxPoint];
+
+    // The cell is the union of the triangles (point, p1, p2) over the segments of its border. For u and v the vectors from the point to p1 and
+    // p2, and c = cross(u, v) twice the signed area (positive as the cells are counter-clockwise), the triangle has the first moment
+    // c (u + v) / 6 and the integral of |x - point|^2 over it is c (u.u + u.v + v.v) / 12. Everything is relative to the point
+    Real doubleArea = 0.;
+    Real momentX    = 0.;
+    Real momentY    = 0.;
+    Real energy     = 0.;
+
+    // With a density, its integrals along the same segments (see DensityMap)
+    const bool                            weighted = !density.empty();
+    typename DensityMap<Scalar>::Moments weightedMoments;
+
+    auto addTriangle = [&](Real x1, Real y1, Real x2, Real y2) {
+        if (weighted)
+            density.addSegment(x1, y1, x2, y2, weightedMoments);
+
+        const Real uX    = x1 - pointX;
+        const Real uY    = y1 - pointY;
+        const Real vX    = x2 - pointX;
+        const Real vY    = y2 - pointY;
+        const Real cross = uX * vY - uY * vX;
+        doubleArea += cross;
+        momentX += (uX + vX) * cross;
+        momentY += (uY + vY) * cross;
+        energy += cross * (uX * uX + uY * uY + uX * vX + uY * vY + vX * vX + vY * vY);
+    };
+
+    if (clipCells && clippedCells.size() == pointList.size())
     {
-        std::cerr << "Error: nearCellulePoints is empty. Cannot sort points." << '\n';
-        return; // Exit if there are no near cell points
+        // The border of the clipped cell is a list of oriented segments, the fan of triangles from the point still covers the cell once
+        for (int i = clippedCells.begin(idxPoint); i + 1 < clippedCells.end(idxPoint); i += 2)
+            addTriangle(clippedCells.x[i], clippedCells.y[i], clippedCells.x[i + 1], clippedCells.y[i + 1]);
     }
-
-    nearCellulePointsTriees.clear();                  // Clear the sorted list before populating it
-    nearCellulePointsTriees.resize(pointList.size()); // Resize to match the number of points
-
-    for (int idxPoint = 0; idxPoint < pointList.size(); ++idxPoint)
+    else
     {
-        Point              point         = pointList[idxPoint];
-        float              energie       = 0.f;
-        std::vector<Point> cellulePoints = nearCellulePoints[idxPoint];
-
-        // Determine all triangles in a celulle
-
-        const int                         nbrTriangles = static_cast<int>(cellulePoints.size()); // Assuming a triangle is formed by 3 points, we have n-2 triangles in a polygon with n points
-        std::vector<std::array<Point, 2>> segmentsTriangles(nbrTriangles);
-
-        for (int i = 0; i < nbrTriangles; ++i)
+        // The vertices of the Voronoi cell are stored in counter-clockwise order, the last one closing the polygon with the first one
+        const Scalar* cx        = nearCellulePointsList.x.data();
+        const Scalar* cy        = nearCellulePointsList.y.data();
+        const int*    triangles = cellTriangles.indices.data();
+        const int     begin     = cellTriangles.begin(idxPoint);
+        const int     end       = cellTriangles.end(idxPoint);
+        for (int i = begin; i < end; ++i)
         {
-            Point pivot          = cellulePoints[i];
-            Point VectorDirector = {pivot.first - point.first, pivot.second - point.second}; // Vector from the pivot to the point
-
-            float minAngle = 10.f; // Initialize the minimum angle to 0
-
-            for (Point& p : cellulePoints)
-            {
-                if (pivot == p)
-                    continue; // Skip the pivot point
-
-                Point pVector = {p.first - point.first, p.second - point.second}; // Vector from the pivot to the point p
-
-                float angle      = std::acos((VectorDirector.first * pVector.first + VectorDirector.second * pVector.second) / (std::sqrt(VectorDirector.first * VectorDirector.first + VectorDirector.second * VectorDirector.second) * std::sqrt(pVector.first * pVector.first + pVector.second * pVector.second)));
-                bool  isNegative = (VectorDirector.first * pVector.second - VectorDirector.second * pVector.first) < 0; // Check if the angle is negative
-                if (isNegative)
-                    angle = 2.f * M_PI - angle; // Adjust the angle to be in the range [0, 2π]
-                if (angle < minAngle)
-                {
-                    minAngle             = angle;
-                    segmentsTriangles[i] = {pivot, p}; // Store the segment formed by the pivot and the point
-                }
-            }
+            const int a = triangles[i];
+            const int b = triangles[i + 1 < end ? i + 1 : begin];
+            addTriangle(cx[a], cy[a], cx[b], cy[b]);
         }
+    }
 
-        nearCellulePointsTriees[idxPoint] = segmentsTriangles; // Store the sorted segments for the current point
+    CellMoments moments;
+    moments.area = doubleArea / 2;
+    if (weighted)
+    {
+        // Integral of rho |x - point|^2 from the integrals of rho, rho x and rho x^2
+        const auto world = density.toWorld(weightedMoments);
+        moments.mass     = static_cast<Real>(world.mass);
+        moments.energy   = static_cast<Real>(world.xx + world.yy - 2 * (pointX * world.x + pointY * world.y) + (pointX * pointX + pointY * pointY) * world.mass);
+        if (world.mass > 0)
+            moments.centroid = Point(static_cast<Scalar>(world.x / world.mass), static_cast<Scalar>(world.y / world.mass));
+        return moments;
     }
+
+    moments.mass   = moments.area;
+    moments.energy = energy / 12;
+    if (doubleArea > 0)
+        moments.centroid = Point(static_cast<Scalar>(pointX + momentX / (3 * doubleArea)), static_cast<Scalar>(pointY + momentY / (3 * doubleArea)));
+    return moments;
 }
 
-float Graphe::calcul_CVT_energie(const int& idxPoint)
+template<typename Precision>
+void BasicGraphe<Precision>::updateFieldFrames()
 {
-    Point              point         = pointList[idxPoint];
-    float              energie       = 0.f;
-    std::vector<Point> cellulePoints = nearCellulePoints[idxPoint];
+    // The density image and the metric field cover the bounding box of the domain
+    const Domain<Scalar>& frame = clippingDomain();
+    density.setFrame(frame.minX(), frame.minY(), frame.maxX(), frame.maxY());
+    metric.setFrame(frame.minX(), frame.minY(), frame.maxX(), frame.maxY());
+}
 
-    // Determine all triangles in a celulle
+template<typename Precision>
+void BasicGraphe<Precision>::updateCellMoments()
+{
+    updateFieldFrames();
+
+    cellMomentsInputs = {cellsGeneration, clippingGeneration, densityGeneration};
+    cellMoments.clear();
+    if (cellTriangles.size() != pointList.size())
+        return; // No cells yet, e.g. a density loaded before the first triangulation
+    cellMoments.resize(pointList.size());
+    threadPool.parallelFor(0, static_cast<int>(pointList.size()), [this](int pointBegin, int pointEnd) {
+        for (int i = pointBegin; i < pointEnd; ++i)
+            cellMoments[i] = computeCellMoments(i);
+    }, 256);
+}
 
-    const int                         nbrTriangles      = static_cast<int>(cellulePoints.size()); // Assuming a triangle is formed by 3 points, we have n-2 triangles in a polygon with n points
-    std::vector<std::array<Point, 2>> segmentsTriangles = nearCellulePointsTriees[idxPoint];      // Get the sorted segments for the current point
+template<typename Precision>
+void BasicGraphe<Precision>::ensureCellMoments()
+{
+    ensureClippedCells(); // The moments of the clipped cells
+    if (cellMomentsInputs != StageInputs{cellsGeneration, clippingGeneration, densityGeneration})
+        updateCellMoments();
+}
 
-    // Calculate the energy for each segment
+template<typename Precision>
+typename BasicGraphe<Precision>::CellMoments BasicGraphe<Precision>::getCellMoments(int idxPoint) const
+{
+    const bool current = cellMomentsInputs == StageInputs{cellsGeneration, clippingGeneration, densityGeneration};
+    if (current && cellMoments.size() == pointList.size() && !pointList.hasFlag(idxPoint, PointFlag::Dirty))
+        return cellMoments[idxPoint];
+    return computeCellMoments(idxPoint); // Not computed for these cells, or the point moved since the cells were built
+}
 
-    float totalEnergy = 0.f;
+template<typename Precision>
+bool BasicGraphe<Precision>::loadDensity(const std::string& path)
+{
+    DensityMap<Scalar> loaded;
+    loaded.setBilinear(density.bilinear());
+    if (!loaded.load(path))
+        return false;
+
+    density = std::move(loaded);
+    densityGeneration++; // The moments are computed again when needed
+    std::cout << "Density loaded from " << path << " : " << density.width() << " x " << density.height() << " pixels\n";
+    return true;
+}
 
-    for (const auto& segment : segmentsTriangles)
+template<typename Precision>
+typename BasicGraphe<Precision>::Real BasicGraphe<Precision>::calcul_CVT_energie(const int& idxPoint)
+{
+    updateFieldFrames();
+    if (useAnisotropic)
     {
-        Point p1 = segment[0];
-        Point p2 = segment[1];
-
-        // For u and v vector director of the triangle, we have to calculate : Area(u, v) * (u.u + v.v - u.v) / 6
+        AnisotropicScratch scratch;
+        return computeAnisotropicCell(idxPoint, clippingDomain(), scratch).energy;
+    }
 
-        Point u     = {p1.first - point.first, p1.second - point.second}; // Vector from the point to p1
-        Point v     = {p2.first - point.first, p2.second - point.second};
-        float uNorm = std::sqrt(u.first * u.first + u.second * u.second);
-        float vNorm = std::sqrt(v.first * v.first + v.second * v.second);
-        float area  = 0.5f * uNorm * vNorm; // Area of the triangle formed by the point, p1, and p2
+    // A single cell does not need the moments of the others : only its clipped border and the frame of the density
+    ensureClippedCells();
+    return getCellMoments(idxPoint).energy;
+}
 
-        totalEnergy += area * (uNorm * uNorm + vNorm * vNorm - (u.first * v.first + u.second * v.second)) / 6.f; // Add the energy of the triangle to the total energy
+template<typename Precision>
+typename BasicGraphe<Precision>::Real BasicGraphe<Precision>::calcul_total_CVT_energie()
+{
+    if (useAnisotropic)
+    {
+        // The energies in the metric of each cell. Without the clipping the cells of the border points are only bounded by the box of the domain
+        updateFieldFrames();
+        const Domain<Scalar>& clipDomain = clippingDomain();
+        AnisotropicScratch    scratch;
+        Real                  energieTotal = 0.0;
+        for (int i = 0; i < static_cast<int>(pointList.size()); ++i)
+        {
+            if (clipCells || !pointList.hasFlag(i, PointFlag::Fixed))
+                energieTotal += computeAnisotropicCell(i, clipDomain, scratch).energy;
+        }
+        return energieTotal;
     }
 
-    return totalEnergy; // Return the total energy calculated for the point
+    // The stages are brought up to date once, then every cell reads its energy from cellMoments (getCellMoments only computes again the
+    // cells of the points moved since the triangulation)
+    updateFieldFrames();
+    ensureCellMoments();
+
+    const bool boundedCells = clipCells && clippedCells.size() == pointList.size(); // Every clipped cell is bounded, the total is the energy of the whole domain
+    Real       energieTotal = 0.0;                                                  // Initialize the total energy
+    for (int i = 0; i < static_cast<int>(pointList.size()); ++i)
+    {
+        if (!boundedCells)
+        {
+            const Real distance = std::sqrt(static_cast<Real>(pointList.x[i]) * pointList.x[i] + static_cast<Real>(pointList.y[i]) * pointList.y[i]); // Calculate the distance from the origin
+            if (distance >= radius * 0.8f)
+                continue; // The cells near the border are cut by the domain, their energy is not meaningful
+        }
+        energieTotal += getCellMoments(i).energy;
+    }
+    return energieTotal;
 }
+
+template struct BasicGraphe<FloatPrecision>;
+template struct BasicGraphe<DoublePrecision>;
+template struct BasicGraphe<MixedPrecision>;
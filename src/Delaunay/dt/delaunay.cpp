@@ -5,6 +5,13 @@ namespace dt {
 template<typename T>
 const std::vector<typename Delaunay<T>::TriangleType>&
     Delaunay<T>::triangulate(std::vector<VertexType>& vertices)
+{
+    return triangulate(vertices, {});
+}
+
+template<typename T>
+const std::vector<typename Delaunay<T>::TriangleType>&
+    Delaunay<T>::triangulate(std::vector<VertexType>& vertices, const std::vector<Type>& weights)
 {
     // Store the vertices locally
     _vertices = vertices;
@@ -42,13 +49,22 @@ const std::vector<typename Delaunay<T>::TriangleType>&
 
     // std::cout << "Before searching" << std::endl;
 
+    // Weight of a vertex of a triangle, the vertices of the super triangle having none
+    const bool weighted = weights.size() == vertices.size();
+    auto weightOf = [&](const VertexType* v) {
+        return v >= vertices.data() && v < vertices.data() + vertices.size() ? weights[v - vertices.data()] : T(0);
+    };
+
     for (auto p = begin(vertices); p != end(vertices); p++)
     {
         std::vector<EdgeType> polygon;
 
         for (auto& t : _triangles)
         {
-            if (t.circumCircleContains(*p))
+            // A vertex in conflict with no triangle is hidden by the others, the polygon stays empty
+            const bool conflict = weighted ? t.powerCircleContains(*p, weightOf(t.a), weightOf(t.b), weightOf(t.c), weights[p - begin(vertices)])
+                                           : t.circumCircleContains(*p);
+            if (conflict)
             {
                 t.isBad = true;
                 polygon.push_back(Edge<T>{*t.a, *t.b});
@@ -39,6 +39,41 @@ Triangle<T>::circumCircleContains(const VertexType &v) const
 	return dist <= circum_radius;
 }
 
+template<typename T>
+bool
+Triangle<T>::powerCircleContains(const VertexType &v, T wa, T wb, T wc, T wv) const
+{
+	// The orthocenter is the circumcenter where each squared norm is lowered by the weight of its vertex
+	const T ab = a->norm2() - wa;
+	const T cd = b->norm2() - wb;
+	const T ef = c->norm2() - wc;
+
+	const T ax = a->x;
+	const T ay = a->y;
+	const T bx = b->x;
+	const T by = b->y;
+	const T cx = c->x;
+	const T cy = c->y;
+
+	// Orientation determinant, relative to a. A flat triangle has no finite orthocircle : it is never in conflict, as the Voronoi side flags
+	// it Degenerate instead of dividing by zero
+	const T abx = bx - ax;
+	const T aby = by - ay;
+	const T acx = cx - ax;
+	const T acy = cy - ay;
+	const T orientation = abx * acy - aby * acx;
+	if (std::abs(orientation) <= std::numeric_limits<T>::epsilon() * (std::abs(abx * acy) + std::abs(aby * acx)))
+		return false;
+
+	const T ortho_x = (ab * (cy - by) + cd * (ay - cy) + ef * (by - ay)) / -orientation;
+	const T ortho_y = (ab * (cx - bx) + cd * (ax - cx) + ef * (bx - ax)) / orientation;
+
+	const VertexType ortho(ortho_x / 2, ortho_y / 2);
+	const T ortho_power = a->dist2(ortho) - wa;
+	const T power = v.dist2(ortho) - wv;
+	return power <= ortho_power;
+}
+
 template<typename T>
 bool
 Triangle<T>::operator ==(const Triangle &t) const
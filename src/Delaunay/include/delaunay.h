@@ -32,6 +32,9 @@ public:
 	Delaunay(Delaunay&&) = delete;
 
 	const std::vector<TriangleType>& triangulate(std::vector<VertexType> &vertices);
+	// Regular triangulation (dual of the power diagram) for one weight per vertex. A vertex whose power cell is empty is hidden : it is in
+	// no triangle
+	const std::vector<TriangleType>& triangulate(std::vector<VertexType> &vertices, const std::vector<Type> &weights);
 	const std::vector<TriangleType>& getTriangles() const;
 	const std::vector<EdgeType>& getEdges() const;
 	const std::vector<VertexType>& getVertices() const;
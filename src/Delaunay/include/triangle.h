@@ -21,6 +21,12 @@ struct Triangle
 
 	bool containsVertex(const VertexType &v) const;
 	bool circumCircleContains(const VertexType &v) const;
+	// Power test of the regular triangulation : whether v, of weight wv, is closer in power distance to the orthocenter of the triangle
+	// (vertices of weights wa, wb and wc) than its vertices. With null weights it is circumCircleContains. A flat triangle is never in conflict.
+	// Bowyer-Watson removes the triangles in conflict with the new vertex and fans it to the border of their union : this assumes the conflict
+	// region is connected (and star-shaped from the vertex), which holds for exact predicates but may fail with the rounding of nearly
+	// cocircular or heavily weighted points
+	bool powerCircleContains(const VertexType &v, T wa, T wb, T wc, T wv) const;
 
 	Triangle &operator=(const Triangle&) = default;
 	Triangle &operator=(Triangle&&) = default;
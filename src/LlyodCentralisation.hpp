@@ -1,17 +1,55 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
 #include <vector>
 #include "Delaunay/include/delaunay.h"
 #include "Delaunay/include/triangle.h"
 #include "Delaunay/include/vector2.h"
+#include "densityMap.hpp"
+#include "domain.hpp"
+#include "frameArena.hpp"
+#include "grapheSnapshot.hpp"
+#include "memoryReport.hpp"
+#include "metricField.hpp"
+#include "pointStorage.hpp"
+#include "rasterVoronoi.hpp"
+#include "spatialGrid.hpp"
+#include "threadPool.hpp"
 #include "utils.hpp"
 
-struct Graphe {
-    using Point     = std::pair<float, float>; // Représente un point (x, y)
-    using Adjacency = std::pair<Point, Point>; // Représente une paire d'indices de points adjacents
-    using Circle    = std::pair<Point, float>; // Représente un cercle avec son centre et son rayon
-    using Triangle  = std::array<Point, 3>;    // Représente un triangle avec ses trois sommets
+// Precision modes of the graph : Storage is the type of the stored coordinates, Real the type of the geometric predicates and of the accumulators
+struct FloatPrecision {
+    using Storage = float;
+    using Real    = float;
+};
+
+struct DoublePrecision {
+    using Storage = double;
+    using Real    = double;
+};
+
+struct MixedPrecision {
+    using Storage = float;
+    using Real    = double;
+};
+
+template<typename Precision>
+struct BasicGraphe {
+    using Scalar    = typename Precision::Storage; // Type of the stored coordinates
+    using Real      = typename Precision::Real;    // Type of the predicates and accumulators
+    using Point     = std::pair<Scalar, Scalar>;   // Représente un point (x, y)
+    using Adjacency = std::pair<Point, Point>;     // Représente une paire d'indices de points adjacents
+    using Circle    = std::pair<Point, Scalar>;    // Représente un cercle avec son centre et son rayon
+    using Triangle  = std::array<Point, 3>;        // Représente un triangle avec ses trois sommets
+    using PointList = BasicPointList<Scalar>;
+    using CellList  = BasicCellList<Scalar>;
+    using Snapshot  = BasicGrapheSnapshot<Scalar>;
 
     float radius = 10.f; // Rayon de la zone d'influence des points
 
@@ -21,27 +59,46 @@ struct Graphe {
     int   currentIdxEnergiePoint = 0;   // Index of the point for which we want to calculate the CVT energy
     float currentCVTEnergie      = 0.f; // Current CVT energy for the point at currentIdxEnergiePoint
 
-    bool useWelzl       = false; // Flag to indicate whether to use Welzl's algorithm for circle calculation
-    bool useCentroid    = true;  // Flag to indicate whether to use the centroid for circle calculation
-    bool useSquare      = false; // Flag to indicate whether to use the square of the distance for energy calculation
-    bool kNearest       = false; // Flag to indicate whether to use the k-nearest neighbors for energy calculation
-    bool useOrientedBox = false; // Flag to control whether to use the oriented bounding box method
-    bool useMean        = false; // Flag to control whether to use the mean for energy calculation
+    bool useWelzl          = false; // Flag to indicate whether to use Welzl's algorithm for circle calculation
+    bool useCentroid       = true;  // Flag to indicate whether to use the centroid for circle calculation
+    bool useSquare         = false; // Flag to indicate whether to use the square of the distance for energy calculation
+    bool kNearest          = false; // Flag to indicate whether to use the k-nearest neighbors for energy calculation
+    bool useOrientedBox    = false; // Flag to control whether to use the oriented bounding box method
+    bool useMinimumAreaBox = false; // With the oriented box method, the smallest area box (rotating calipers) instead of the principal axes
+    bool useMean           = false; // Flag to control whether to use the mean for energy calculation
+    bool useRaster         = false; // Flag to move the points to the centroids of their cells on a raster grid (jump flooding)
+    bool useAnisotropic    = false; // Flag to move the points to the centroids of their anisotropic cells in the metric field
 
     Point welzlCenterOf0;    // Center of the circle calculated by Welzl's algorithm
     Point centroidCenterOf0; // Center of the centroid calculated from the points
 
-    std::vector<Point> pointList; // Exemple: [ (x0, y0), (x1, y1), ...]
+    PointList           pointList;   // Exemple: x = [x0, x1, ...], y = [y0, y1, ...]
+    SpatialGrid<Scalar> spatialGrid; // Spatial index of pointList, used for every nearest/radius/duplicate query on the points
+
+    std::vector<std::vector<int>> pointsAdjacentsIdx;      // List of adjacent points for each point in pointList
+    IndexLists                    cellTriangles;           // Triangles around each point : their circumcenters in nearCellulePointsList are the vertices of its cell
+    std::vector<int>              nearCellulePointsTriees; // For each entry of cellTriangles, index of the next entry of the same cell in counter-clockwise order (-1 if none)
+    std::vector<std::array<int, 2>> hullNeighbors;         // For the points of the convex hull, the next and the previous point along the hull ({-1, -1} inside)
+
+    // The previous triangulation and its rings : the ring of a point whose star did not change is renumbered instead of being built again
+    std::vector<std::array<int, 3>> previousTriangles;
+    IndexLists                      previousCellTriangles;
+    std::vector<int>                previousCellSuccessors;
+    int                             nbrReusedRings = 0; // Rings of the last triangulation taken from the previous one
 
-    std::vector<std::vector<int>>                  pointsAdjacentsIdx; // List of adjacent points for each point in pointList
-    std::vector<std::vector<Point>>                nearCellulePoints;
-    std::vector<std::vector<std::array<Point, 2>>> nearCellulePointsTriees; // List of segments formed by the near cell points
+    bool     clipCells = true; // Clip the cells to the domain : every point gets a bounded cell, the border points are centralised too and the energy is exact
+    CellList clippedCells;     // Border of the cell of each point clipped to the domain, as oriented segments (pairs of points) with the cell on their left
 
-    std::vector<Point> nearCellulePointsList; // List of points that are near the cell
+    std::shared_ptr<const Domain<Scalar>> domain;     // Domain loaded from a file, nullptr for the disc of radius
+    std::shared_ptr<const Domain<Scalar>> discDomain; // Polygon of the disc, used when no domain is loaded
+
+    PointList          nearCellulePointsList; // Circumcenter of each triangle of idxTriangles, the Voronoi vertices shared by the cells (Degenerate for the invalid triangles)
     std::vector<Point> celluleBorder;         // Indices of the centers that are considered border points
 
-    std::vector<int> idxPointBorder;            // Indices of the points that are considered border points
-    bool             hasDetectedBorder = false; // Flag to indicate if border points have been detected
+    float                            duplicateDistance = 1e-3f; // Two points closer than this are considered as duplicates and separated before the triangulation
+    std::vector<std::pair<int, int>> separatedDuplicates;       // Pairs (kept point, moved point) separated by the last duplicate pass
+
+    bool hasDetectedBorder = false; // Flag to indicate if border points have been detected (the border points carry PointFlag::Border in pointList.flags)
 
     std::vector<std::array<int, 3>> idxTriangles;    // List of indices of points in triangles
     std::vector<Circle>             triangleCircles; // List of circles formed by the near cell points
@@ -52,12 +109,125 @@ struct Graphe {
 
     std::vector<double> energies; // List of energies after each iterations
 
-    int                             k = 8;          // Number of nearest neighbors to consider for k-nearest points
-    std::vector<std::vector<Point>> kNearestPoints; // List of k-nearest points for each point in pointList
+    DensityMap<Scalar>  density; // Density of the points over the domain, uniform if empty
+    MetricField<Scalar> metric;  // Metric of the anisotropic cells over the domain, the identity if empty
+
+    std::vector<Real> powerWeights;                // Weight w of each point, its cell being where |x - p|^2 - w is the lowest (power diagram). Empty for the Voronoi diagram
+    bool              capacityConstrained = false; // Solve powerWeights after each triangulation so that every cell has the same mass (see solveCapacityWeights)
+    int               capacityMaxSteps    = 30;    // Newton steps of a solve at most
+    Real              capacityTolerance   = 1e-3;  // Largest relative error on the mass of a cell accepted by the solve
+    int               capacitySteps       = 0;     // Newton steps of the last solve
+    Real              capacityError       = 0;     // Largest relative error on the mass of a cell after the last solve
+
+    // Moments of a cell, from one pass over its border triangulated from the generator
+    struct CellMoments {
+        Real  area = 0;   // Area of the cell
+        Real  mass = 0;   // Integral of the density over the cell (the area for the uniform density)
+        Point centroid;   // Centroid of the cell weighted by the density, meaningful if mass > 0
+        Real  energy = 0; // Polar second moment about the generator weighted by the density : the CVT energy of the cell
+    };
+    std::vector<CellMoments> cellMoments; // Moments of every cell, computed when a consumer needs them (see ensureCellMoments)
+
+    // The derived stages are computed on demand and stamped with the generations of their inputs : the clipped cells depend on the cells and
+    // the domain, the moments on the clipped cells and the density. A stage whose stamp is current is not computed again
+    struct StageInputs {
+        std::uint64_t cells    = 0;
+        std::uint64_t clipping = 0;
+        std::uint64_t density  = 0;
+
+        bool operator==(const StageInputs&) const = default;
+    };
+    std::uint64_t cellsGeneration     = 1;     // Bumped by each triangulation
+    std::uint64_t clippingGeneration  = 1;     // Bumped when the domain or clipCells change
+    std::uint64_t densityGeneration   = 1;     // Bumped when the density or its interpolation change
+    StageInputs   clippedCellsInputs;          // Generations of the inputs of clippedCells
+    StageInputs   cellMomentsInputs;           // Generations of the inputs of cellMoments
+    bool          publishClippedCells = false; // The renderer draws the clipped cells, so publishSnapshot() builds and copies them
+
+    int      k = 8;          // Number of nearest neighbors to consider for k-nearest points
+    CellList kNearestPoints; // List of k-nearest points for each point in pointList
+
+    // Buffers of the k-nearest queries of one band of points, kept from one iteration to the next so the queries allocate nothing
+    struct KNearestScratch {
+        std::vector<int>                    nearest;    // Indices returned by the spatial grid
+        std::vector<std::pair<Scalar, int>> candidates; // Heap of the query
+    };
+    std::vector<KNearestScratch> kNearestScratch; // One per band, see centralisation()
+
+    FrameArena centralisationArena; // Memory of the per-point temporaries of centralisation(), rewound at each iteration
+    ThreadPool threadPool;          // Threads of the parallel loops of an iteration
+
+    // Jacobi sweep : the targets are computed from the positions of the previous iteration, in parallel, instead of moving each point before
+    // the next one reads it (Gauss-Seidel). The new positions are written in the second buffer, swapped with the positions at the end
+    bool                  jacobiSweep = false;
+    AlignedVector<Scalar> jacobiX;
+    AlignedVector<Scalar> jacobiY;
+
+    int                   rasterResolution = 1024; // Number of pixels along the longer side of the domain for the raster cells
+    RasterVoronoi<Scalar> rasterVoronoi;           // Cells of the last raster centralisation
+
+    MemoryUsage triangulationMemory{"dt::Delaunay (freed after the triangulation)"}; // Internals of the last triangulation, measured before they are freed
+
+    std::shared_ptr<const Snapshot> publishedSnapshot; // Last published state, only accessed through std::atomic_load/atomic_store
+    std::shared_ptr<Snapshot>       spareSnapshot;     // Previous snapshot which nobody reads anymore, its memory is reused by the next one
+
+    // Copy the drawable state in a snapshot and publish it, the readers holding the previous one keep it alive until they release it
+    void publishSnapshot()
+    {
+        std::shared_ptr<Snapshot> next = std::move(spareSnapshot);
+        if (!next)
+            next = std::make_shared<Snapshot>();
+
+        next->points                 = pointList; // Copy assignments reuse the capacity of the spare snapshot
+        next->triangles              = idxTriangles;
+        next->cellTriangles          = cellTriangles;
+        next->cellSuccessors         = nearCellulePointsTriees;
+        if (publishClippedCells)
+        {
+            ensureClippedCells();
+            next->clippedCells = clippedCells;
+        }
+        else
+        {
+            next->clippedCells.clear(); // Not drawn, not built
+        }
+        next->domain                 = domain;
+        next->circumcenters          = nearCellulePointsList;
+        next->triangleCircles        = triangleCircles;
+        next->orientedBoxes          = allOrientedBoxes;
+        next->nbrCentralisation      = nbrCentralisation;
+        next->nbrSeparatedDuplicates = separatedDuplicates.size();
+        next->capacitySteps          = capacityConstrained ? capacitySteps : -1;
+        next->capacityError          = static_cast<double>(capacityError);
+
+        std::shared_ptr<const Snapshot> previous = std::atomic_exchange(&publishedSnapshot, std::shared_ptr<const Snapshot>(std::move(next)));
+        if (previous && previous.use_count() == 1) // Not published anymore and not held by a reader
+            spareSnapshot = std::const_pointer_cast<Snapshot>(previous);
+    }
+
+    // Last published snapshot, safe to call from any thread
+    std::shared_ptr<const Snapshot> snapshot() const
+    {
+        return std::atomic_load(&publishedSnapshot);
+    }
 
     void centralisation();
 
-    bool floatEqual(const float& a, const float& b, float epsilon = 0.0001)
+    void generateRandomPoints(int nbrRandomPoints, int nbrBorderPoints); // Replace the points by random points in the disc and evenly spaced points on its border
+
+    MemoryReport memory_report() const; // Memory used by each structure of the graph, not to be called while an iteration runs
+
+    // Copy of the vertices of the cell of the point i, for the code paths which are not performance sensitive
+    std::vector<Point> cellVertices(int i) const
+    {
+        std::vector<Point> vertices;
+        vertices.reserve(cellTriangles.count(i));
+        for (int j = cellTriangles.begin(i); j < cellTriangles.end(i); ++j)
+            vertices.push_back(nearCellulePointsList[cellTriangles.indices[j]]);
+        return vertices;
+    }
+
+    bool floatEqual(const Scalar& a, const Scalar& b, Scalar epsilon = 0.0001)
     {
         return (std::abs(a - b) < epsilon);
     }
@@ -67,57 +237,120 @@ struct Graphe {
         return (floatEqual(p1.first, p2.first) && floatEqual(p1.second, p2.second));
     }
 
+    // Move the point i, keeping the spatial index up to date
+    void movePoint(int i, const Point& p)
+    {
+        pointList.set(i, p);
+        pointList.setFlag(i, PointFlag::Dirty);
+        if (spatialGrid.isBuiltFor(pointList))
+            spatialGrid.update(pointList, i);
+    }
+
+    // Build the spatial index if the set of points changed since it was built (generation of pointList), otherwise move the points flagged
+    // dirty by a direct write. Called before every query on the grid
+    void refreshSpatialGrid()
+    {
+        if (!spatialGrid.isBuiltFor(pointList))
+        {
+            spatialGrid.build(pointList);
+            return;
+        }
+        for (int i = 0; i < static_cast<int>(pointList.size()); ++i)
+        {
+            if (pointList.hasFlag(i, PointFlag::Dirty))
+                spatialGrid.update(pointList, i);
+        }
+    }
+
     int getIndexFromPoint(const Point& p)
     {
-        for (int i = 0; i < pointList.size(); ++i)
+        refreshSpatialGrid();
+        const int idx = spatialGrid.exactMatch(pointList, p, Scalar(0.0001));
+        if (idx == -1)
+            std::cerr << "Point not found in the graph: (" << p.first << ", " << p.second << ")" << '\n';
+        return idx; // -1 if the point is not found
+    }
+
+    bool hasPowerWeights() const { return powerWeights.size() == pointList.size(); }
+
+    // Circumcircle of the triangle, or with powerWeights its orthocircle : the center is the vertex of the power diagram, at the same power
+    // distance from the three points
+    Circle computeCircumcircle(int idxA, int idxB, int idxC) const
+    {
+        const Real ax = pointList.x[idxA];
+        const Real ay = pointList.y[idxA];
+        const Real bx = static_cast<Real>(pointList.x[idxB]) - ax;
+        const Real by = static_cast<Real>(pointList.y[idxB]) - ay;
+        const Real cx = static_cast<Real>(pointList.x[idxC]) - ax;
+        const Real cy = static_cast<Real>(pointList.y[idxC]) - ay;
+
+        // Flat (collinear or duplicate) triangle : no finite circumcenter, the circle on its longest edge keeps the vertex finite, as in the
+        // power test of the triangulation
+        const Real orientation = bx * cy - by * cx;
+        if (std::abs(orientation) <= std::numeric_limits<Real>::epsilon() * (std::abs(bx * cy) + std::abs(by * cx)))
         {
-            // std::cout << "Comparing point: " << pointList[i].first << ", " << pointList[i].second
-            //           << " with point: " << p.first << ", " << p.second << std::endl;
-            if (pointEqual(pointList[i], p))
+            const Real ab = bx * bx + by * by;
+            const Real ac = cx * cx + cy * cy;
+            const Real bc = (bx - cx) * (bx - cx) + (by - cy) * (by - cy);
+            Real       mx = bx / 2;
+            Real       my = by / 2;
+            if (bc >= ab && bc >= ac)
+            {
+                mx = (bx + cx) / 2;
+                my = (by + cy) / 2;
+            }
+            else if (ac > ab)
             {
-                return i;
+                mx = cx / 2;
+                my = cy / 2;
             }
+            const Real radius = std::sqrt(std::max({ab, ac, bc})) / 2;
+            return Circle(Point(static_cast<Scalar>(ax + mx), static_cast<Scalar>(ay + my)), static_cast<Scalar>(radius));
         }
-        std::cerr << "Point not found in the graph: (" << p.first << ", " << p.second << ")" << '\n';
-        return -1; // Point not found
+
+        const bool weighted = hasPowerWeights();
+        const Real wa       = weighted ? powerWeights[idxA] : 0;
+        const Real d        = 2 * orientation;
+        const Real b2       = bx * bx + by * by - (weighted ? powerWeights[idxB] - wa : 0);
+        const Real c2       = cx * cx + cy * cy - (weighted ? powerWeights[idxC] - wa : 0);
+        const Real ux       = (cy * b2 - by * c2) / d;
+        const Real uy       = (bx * c2 - cx * b2) / d;
+
+        const Real radius2 = ux * ux + uy * uy - wa; // Negative for an imaginary orthocircle, drawn as a point
+        return Circle(Point(static_cast<Scalar>(ax + ux), static_cast<Scalar>(ay + uy)), static_cast<Scalar>(std::sqrt(std::max(radius2, Real(0)))));
     }
 
-    void set_triangles(const std::vector<dt::Triangle<double>>& triangles)
+    void addTriangleAdjacency(int idxA, int idxB, int idxC)
+    {
+        if (std::find(pointsAdjacentsIdx[idxA].begin(), pointsAdjacentsIdx[idxA].end(), idxB) == pointsAdjacentsIdx[idxA].end())
+            pointsAdjacentsIdx[idxA].push_back(idxB);
+        if (std::find(pointsAdjacentsIdx[idxA].begin(), pointsAdjacentsIdx[idxA].end(), idxC) == pointsAdjacentsIdx[idxA].end())
+            pointsAdjacentsIdx[idxA].push_back(idxC);
+        if (std::find(pointsAdjacentsIdx[idxB].begin(), pointsAdjacentsIdx[idxB].end(), idxA) == pointsAdjacentsIdx[idxB].end())
+            pointsAdjacentsIdx[idxB].push_back(idxA);
+        if (std::find(pointsAdjacentsIdx[idxB].begin(), pointsAdjacentsIdx[idxB].end(), idxC) == pointsAdjacentsIdx[idxB].end())
+            pointsAdjacentsIdx[idxB].push_back(idxC);
+        if (std::find(pointsAdjacentsIdx[idxC].begin(), pointsAdjacentsIdx[idxC].end(), idxA) == pointsAdjacentsIdx[idxC].end())
+            pointsAdjacentsIdx[idxC].push_back(idxA);
+        if (std::find(pointsAdjacentsIdx[idxC].begin(), pointsAdjacentsIdx[idxC].end(), idxB) == pointsAdjacentsIdx[idxC].end())
+            pointsAdjacentsIdx[idxC].push_back(idxB);
+    }
+
+    // The vertices of the triangles point into the array given to the triangulation, so the index of a vertex is its offset in that array
+    void set_triangles(const std::vector<dt::Triangle<Real>>& triangles, const dt::Vector2<Real>* vertices)
     {
         idxTriangles.clear();
+        idxTriangles.reserve(triangles.size());
         pointsAdjacentsIdx.clear();
         pointsAdjacentsIdx.resize(pointList.size()); // Resize the adjacency list to match the number of points
-        triangleCircles.clear();                     // Clear the list of triangle circles before setting new triangles
-        triangleCircles.reserve(triangles.size());   // Reserve space for the triangle circles to avoid
         for (const auto& triangle : triangles)
         {
-            Point p1   = {triangle.a->x, triangle.a->y}; // Get the first point of the triangle
-            Point p2   = {triangle.b->x, triangle.b->y}; // Get the second point of the triangle
-            Point p3   = {triangle.c->x, triangle.c->y}; // Get the third point of the triangle
-            int   idxA = getIndexFromPoint(p1);
-            int   idxB = getIndexFromPoint(p2);
-            int   idxC = getIndexFromPoint(p3);
+            int idxA = static_cast<int>(triangle.a - vertices);
+            int idxB = static_cast<int>(triangle.b - vertices);
+            int idxC = static_cast<int>(triangle.c - vertices);
             idxTriangles.emplace_back(std::array<int, 3>{idxA, idxB, idxC}); // Add the indices of the triangle points
 
-            if (idxA == -1 || idxB == -1 || idxC == -1)
-            {
-                triangleCircles.emplace_back(Circle{});
-                std::cerr << "Error: One of the triangle points is not found in the graph." << '\n';
-                continue; // Skip this triangle if any point is not found
-            }
-
-            if (std::find(pointsAdjacentsIdx[idxA].begin(), pointsAdjacentsIdx[idxA].end(), idxB) == pointsAdjacentsIdx[idxA].end())
-                pointsAdjacentsIdx[idxA].push_back(idxB);
-            if (std::find(pointsAdjacentsIdx[idxA].begin(), pointsAdjacentsIdx[idxA].end(), idxC) == pointsAdjacentsIdx[idxA].end())
-                pointsAdjacentsIdx[idxA].push_back(idxC);
-            if (std::find(pointsAdjacentsIdx[idxB].begin(), pointsAdjacentsIdx[idxB].end(), idxA) == pointsAdjacentsIdx[idxB].end())
-                pointsAdjacentsIdx[idxB].push_back(idxA);
-            if (std::find(pointsAdjacentsIdx[idxB].begin(), pointsAdjacentsIdx[idxB].end(), idxC) == pointsAdjacentsIdx[idxB].end())
-                pointsAdjacentsIdx[idxB].push_back(idxC);
-            if (std::find(pointsAdjacentsIdx[idxC].begin(), pointsAdjacentsIdx[idxC].end(), idxA) == pointsAdjacentsIdx[idxC].end())
-                pointsAdjacentsIdx[idxC].push_back(idxA);
-            if (std::find(pointsAdjacentsIdx[idxC].begin(), pointsAdjacentsIdx[idxC].end(), idxB) == pointsAdjacentsIdx[idxC].end())
-                pointsAdjacentsIdx[idxC].push_back(idxB);
+            addTriangleAdjacency(idxA, idxB, idxC);
 
             // // Get the circumcircle of the current triangle
             // if (std::find(idxPointBorder.begin(), idxPointBorder.end(), idxA) != idxPointBorder.end()
@@ -127,28 +360,19 @@ struct Graphe {
             //     triangleCircles.emplace_back(Circle{});
             //     continue; // Skip this triangle if any point is a border point
             // }
+        }
 
-            Circle currentCircle;
-
-            std::array<std::array<float, 3>, 3> matForX{{{1.f, (p1.second), static_cast<float>(((std::pow(p1.second, 2) + std::pow(p1.first, 2)) / 2.))},   // L1
-                                                         {1.f, (p2.second), static_cast<float>(((std::pow(p2.second, 2) + std::pow(p2.first, 2)) / 2.))},   // L2
-                                                         {1.f, (p3.second), static_cast<float>(((std::pow(p3.second, 2) + std::pow(p3.first, 2)) / 2.))}}}; // L3
-
-            auto x = static_cast<float>(-determinant3x3(matForX));
-
-            std::array<std::array<float, 3>, 3> matForY{{{1.f, static_cast<float>(p1.first), static_cast<float>((std::pow(p1.second, 2) + std::pow(p1.first, 2)) / 2.)}, {1.f, static_cast<float>(p2.first), static_cast<float>((std::pow(p2.second, 2) + std::pow(p2.first, 2)) / 2.)}, {1.f, static_cast<float>(p3.first), static_cast<float>((std::pow(p3.second, 2) + std::pow(p3.first, 2)) / 2.)}}};
-
-            auto y = static_cast<float>(determinant3x3(matForY));
-
-            std::array<std::array<float, 3>, 3> matForW{{{1.f, static_cast<float>(p1.first), static_cast<float>(p1.second)}, {1.f, static_cast<float>(p2.first), static_cast<float>(p2.second)}, {1.f, static_cast<float>(p3.first), static_cast<float>(p3.second)}}};
-
-            auto w = static_cast<float>(determinant3x3(matForW));
-
-            Point center(x / w, y / w); // Calculate the center of the circumcircle
+        updateTriangleCircles();
+    }
 
-            currentCircle = Circle(center, std::sqrt(std::pow(p1.first - center.first, 2) + std::pow(p1.second - center.second, 2))); // Calculate the radius of the circumcircle
-            triangleCircles.emplace_back(currentCircle);                                                                              // Add the circle to the list of triangle circles
-        }
+    // The circumcircles only depend on their triangle, they are computed in parallel
+    void updateTriangleCircles()
+    {
+        triangleCircles.resize(idxTriangles.size());
+        threadPool.parallelFor(0, static_cast<int>(idxTriangles.size()), [this](int triangleBegin, int triangleEnd) {
+            for (int t = triangleBegin; t < triangleEnd; ++t)
+                triangleCircles[t] = computeCircumcircle(idxTriangles[t][0], idxTriangles[t][1], idxTriangles[t][2]); // Add the circle to the list of triangle circles
+        }, 1024);
     }
 
     void set_triangle_v2()
@@ -165,21 +389,11 @@ struct Graphe {
             if (idxA == -1 || idxB == -1 || idxC == -1)
             {
                 std::cerr << "Error: One of the triangle points is not found in the graph." << '\n';
-                continue; // Skip this triangle if any point is not found
+                triangleCircles.emplace_back(Circle{}); // Keep triangleCircles aligned with idxTriangles
+                continue;                               // Skip this triangle if any point is not found
             }
 
-            if (std::find(pointsAdjacentsIdx[idxA].begin(), pointsAdjacentsIdx[idxA].end(), idxB) == pointsAdjacentsIdx[idxA].end())
-                pointsAdjacentsIdx[idxA].push_back(idxB);
-            if (std::find(pointsAdjacentsIdx[idxA].begin(), pointsAdjacentsIdx[idxA].end(), idxC) == pointsAdjacentsIdx[idxA].end())
-                pointsAdjacentsIdx[idxA].push_back(idxC);
-            if (std::find(pointsAdjacentsIdx[idxB].begin(), pointsAdjacentsIdx[idxB].end(), idxA) == pointsAdjacentsIdx[idxB].end())
-                pointsAdjacentsIdx[idxB].push_back(idxA);
-            if (std::find(pointsAdjacentsIdx[idxB].begin(), pointsAdjacentsIdx[idxB].end(), idxC) == pointsAdjacentsIdx[idxB].end())
-                pointsAdjacentsIdx[idxB].push_back(idxC);
-            if (std::find(pointsAdjacentsIdx[idxC].begin(), pointsAdjacentsIdx[idxC].end(), idxA) == pointsAdjacentsIdx[idxC].end())
-                pointsAdjacentsIdx[idxC].push_back(idxA);
-            if (std::find(pointsAdjacentsIdx[idxC].begin(), pointsAdjacentsIdx[idxC].end(), idxB) == pointsAdjacentsIdx[idxC].end())
-                pointsAdjacentsIdx[idxC].push_back(idxB);
+            addTriangleAdjacency(idxA, idxB, idxC);
 
             // if (std::find(idxPointBorder.begin(), idxPointBorder.end(), idxA) != idxPointBorder.end()
             //     || std::find(idxPointBorder.begin(), idxPointBorder.end(), idxB) != idxPointBorder.end()
@@ -189,45 +403,56 @@ struct Graphe {
             //     continue; // Skip this triangle if any point is a border point
             // }
             // Get the circumcircle of the current triangle
-            Point p1 = pointList[idxA];
-            Point p2 = pointList[idxB];
-            Point p3 = pointList[idxC];
-
-            Circle currentCircle;
-
-            std::array<std::array<float, 3>, 3> matForX{{{1.f, (p1.second), static_cast<float>(((std::pow(p1.second, 2) + std::pow(p1.first, 2)) / 2.))},   // L1
-                                                         {1.f, (p2.second), static_cast<float>(((std::pow(p2.second, 2) + std::pow(p2.first, 2)) / 2.))},   // L2
-                                                         {1.f, (p3.second), static_cast<float>(((std::pow(p3.second, 2) + std::pow(p3.first, 2)) / 2.))}}}; // L3
-
-            auto x = static_cast<float>(-determinant3x3(matForX));
-
-            std::array<std::array<float, 3>, 3> matForY{{{1.f, static_cast<float>(p1.first), static_cast<float>((std::pow(p1.second, 2) + std::pow(p1.first, 2)) / 2.)}, {1.f, static_cast<float>(p2.first), static_cast<float>((std::pow(p2.second, 2) + std::pow(p2.first, 2)) / 2.)}, {1.f, static_cast<float>(p3.first), static_cast<float>((std::pow(p3.second, 2) + std::pow(p3.first, 2)) / 2.)}}};
-
-            auto y = static_cast<float>(determinant3x3(matForY));
-
-            std::array<std::array<float, 3>, 3> matForW{{{1.f, static_cast<float>(p1.first), static_cast<float>(p1.second)}, {1.f, static_cast<float>(p2.first), static_cast<float>(p2.second)}, {1.f, static_cast<float>(p3.first), static_cast<float>(p3.second)}}};
-
-            auto w = static_cast<float>(determinant3x3(matForW));
-
-            Point center(x / w, y / w); // Calculate the center of the circumcircle
-
-            currentCircle = Circle(center, std::sqrt(std::pow(p1.first - center.first, 2) + std::pow(p1.second - center.second, 2))); // Calculate the radius of the circumcircle
-            triangleCircles.emplace_back(currentCircle);                                                                              // Add the circle to the list of triangle circles
+            triangleCircles.emplace_back(computeCircumcircle(idxA, idxB, idxC)); // Add the circle to the list of triangle circles
         }
     }
 
+    int  separateNearDuplicates(); // Move apart the points closer than duplicateDistance, returns the number of points moved
     void doDelaunayAndCalculateCenters();
+    void triangulateAndBuildCells(); // Triangulation of the current points (regular with powerWeights) and their cells
+    int  solveCapacityWeights();     // Newton on powerWeights until every cell has the same mass, returns the number of steps
     void doDelaunayFlipVersion(int& nbrFlips);
     int  flipDelaunayTriangles();
 
     void calculateCenterFromDelaunayTriangles(const std::vector<std::array<int, 3>>& triangles);
 
+    void                  clipCellsToDomain();                 // Fill clippedCells from the Voronoi cells
+    void                  ensureClippedCells();                // clipCellsToDomain() if the cells or the domain changed since the last one
+    const Domain<Scalar>& clippingDomain();                    // The loaded domain, or the disc
+    bool                  loadDomain(const std::string& path); // Use the domain of a file (see Domain::load), false if it can not be read
+
     void findBorderPoints();
     bool hasOtherTriangleForSegment(const std::vector<Triangle>& trianglesPoints, const Point& p1, const Point& p2, const Point& excluded);
     void findBorderPoints_BROKEN_Function();
 
-    float calcul_CVT_energie(const int& idxPoint);
-    void  triesNearCellulePoints(); // Sort the near cell points based on their distance to the current energy point
+    CellMoments computeCellMoments(int idxPoint) const; // Area, centroid and energy of the clipped cell of the point, or of its Voronoi cell
+    void        updateCellMoments();                    // Fill cellMoments for the current cells, in parallel
+    void        ensureCellMoments();                    // updateCellMoments() (and the clipping) if one of their inputs changed since the last one
+    void        updateFieldFrames();                    // Stretch the density and the metric field over the bounding box of the domain
+    CellMoments getCellMoments(int idxPoint) const;     // The moments of cellMoments, or computed again if they are stale or the point moved since
+    bool        loadDensity(const std::string& path);   // Use the density of an image (see DensityMap::load), false if it can not be read
+
+    // Scratch buffers of computeAnisotropicCell, reused from one cell to the next
+    struct AnisotropicScratch {
+        std::vector<int>                   neighbors;
+        std::vector<std::pair<Real, Real>> polygon;
+        std::vector<std::pair<Real, Real>> clipped;
+        std::vector<int>                   candidates;
+        std::vector<Real>                  cuts;
+    };
+    // Area, centroid and energy of the cell of the point in its metric, clipped to clipDomain (the clippingDomain(), resolved by the caller
+    // so that the cells can be computed in parallel)
+    CellMoments computeAnisotropicCell(int idxPoint, const Domain<Scalar>& clipDomain, AnisotropicScratch& scratch) const;
+    bool        loadMetric(const std::string& path); // Use the metric field of a file (see MetricField::load), false if it can not be read
+
+    Real  calcul_CVT_energie(const int& idxPoint);
+    Real  calcul_total_CVT_energie(); // Sum of the energies of every clipped cell, or of the points far enough from the border without clipping
 
     void updateCenterExample();
 };
+
+#ifndef GRAPHE_PRECISION
+#define GRAPHE_PRECISION MixedPrecision
+#endif
+
+using Graphe = BasicGraphe<GRAPHE_PRECISION>; // Precision used by the application, chosen with the GRAPHE_PRECISION CMake option
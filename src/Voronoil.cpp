@@ -1,52 +1,282 @@
 #include <algorithm>
+#include <atomic>
 #include <iostream>
 #include "LlyodCentralisation.hpp"
 #include "utils.hpp"
 
-void Graphe::calculateCenterFromDelaunayTriangles(const std::vector<std::array<int, 3>>& triangles)
+template<typename Precision>
+void BasicGraphe<Precision>::calculateCenterFromDelaunayTriangles(const std::vector<std::array<int, 3>>& triangles)
 {
-    for (const auto& triangle : triangles)
-    {
-        std::array<std::array<float, 3>, 3> matForX{{{1.f, (pointList[triangle[0]].second), static_cast<float>(((std::pow(pointList[triangle[0]].second, 2) + std::pow(pointList[triangle[0]].first, 2)) / 2.))},   // L1
-                                                     {1.f, (pointList[triangle[1]].second), static_cast<float>(((std::pow(pointList[triangle[1]].second, 2) + std::pow(pointList[triangle[1]].first, 2)) / 2.))},   // L2
-                                                     {1.f, (pointList[triangle[2]].second), static_cast<float>(((std::pow(pointList[triangle[2]].second, 2) + std::pow(pointList[triangle[2]].first, 2)) / 2.))}}}; // L3
+    const int nbrPoints    = static_cast<int>(pointList.size());
+    const int nbrTriangles = static_cast<int>(triangles.size());
+
+    // The rings of the previous triangulation, to reuse the ones whose star did not change
+    std::swap(cellTriangles, previousCellTriangles);
+    std::swap(nearCellulePointsTriees, previousCellSuccessors);
+    const bool hasPrevious = previousCellTriangles.size() == static_cast<std::size_t>(nbrPoints) && !previousTriangles.empty();
+
+    // First pass, over the triangles : the circumcenter, the counter-clockwise order of the vertices and the number of triangles around each
+    // point. Every triangle only writes its own entries, the counts are atomic. The triangle is also matched with the same triangle of the
+    // previous triangulation : at the same index (flips), or in the previous fan of its first vertex (new triangulation)
+    std::vector<std::array<int, 3>> ccwTriangles(nbrTriangles);
+    std::vector<int>                counts(nbrPoints, 0);
+    std::vector<int>                previousToNew(hasPrevious ? previousTriangles.size() : 0, -1);
+    std::atomic<int>                nbrInvalid = 0;
+    nearCellulePointsList.resize(nbrTriangles); // One circumcenter per triangle, the cells only store the indices of their triangles
+
+    auto sameTriangle = [](const std::array<int, 3>& a, const std::array<int, 3>& b) {
+        return (a[0] == b[0] || a[0] == b[1] || a[0] == b[2]) && (a[1] == b[0] || a[1] == b[1] || a[1] == b[2])
+            && (a[2] == b[0] || a[2] == b[1] || a[2] == b[2]);
+    };
+
+    threadPool.parallelFor(0, nbrTriangles, [&](int triangleBegin, int triangleEnd) {
+        for (int t = triangleBegin; t < triangleEnd; ++t)
+        {
+            int aIdx = triangles[t][0]; // Get the index of the point in the graph
+            int bIdx = triangles[t][1]; // Get the index of the point in the graph
+            int cIdx = triangles[t][2]; // Get the index of the point in the graph
 
-        auto x = static_cast<float>(-determinant3x3(matForX));
+            if (aIdx == -1 || bIdx == -1 || cIdx == -1)
+            {
+                nbrInvalid++;
+                ccwTriangles[t] = {-1, -1, -1};
+                nearCellulePointsList.set(t, Point{});
+                nearCellulePointsList.flags[t] = PointFlag::Degenerate; // Keep nearCellulePointsList aligned with the triangles
+                continue;                                               // Skip this triangle if any point is not found
+            }
 
-        std::array<std::array<float, 3>, 3> matForY{{{1.f, static_cast<float>(pointList[triangle[0]].first), static_cast<float>((std::pow(pointList[triangle[0]].second, 2) + std::pow(pointList[triangle[0]].first, 2)) / 2.)}, {1.f, static_cast<float>(pointList[triangle[1]].first), static_cast<float>((std::pow(pointList[triangle[1]].second, 2) + std::pow(pointList[triangle[1]].first, 2)) / 2.)}, {1.f, static_cast<float>(pointList[triangle[2]].first), static_cast<float>((std::pow(pointList[triangle[2]].second, 2) + std::pow(pointList[triangle[2]].first, 2)) / 2.)}}};
+            // The triangulation does not orient its triangles
+            const Real abX = static_cast<Real>(pointList.x[bIdx]) - pointList.x[aIdx];
+            const Real abY = static_cast<Real>(pointList.y[bIdx]) - pointList.y[aIdx];
+            const Real acX = static_cast<Real>(pointList.x[cIdx]) - pointList.x[aIdx];
+            const Real acY = static_cast<Real>(pointList.y[cIdx]) - pointList.y[aIdx];
+            if (abX * acY - abY * acX < 0)
+                std::swap(bIdx, cIdx);
+            ccwTriangles[t] = {aIdx, bIdx, cIdx};
 
-        auto y = static_cast<float>(determinant3x3(matForY));
+            nearCellulePointsList.set(t, triangleCircles[t].first); // Add the center to the nearCellulePointsList
+            nearCellulePointsList.flags[t] = PointFlag::None;
 
-        std::array<std::array<float, 3>, 3> matForW{{{1.f, static_cast<float>(pointList[triangle[0]].first), static_cast<float>(pointList[triangle[0]].second)}, {1.f, static_cast<float>(pointList[triangle[1]].first), static_cast<float>(pointList[triangle[1]].second)}, {1.f, static_cast<float>(pointList[triangle[2]].first), static_cast<float>(pointList[triangle[2]].second)}}};
+            for (const int idx : ccwTriangles[t])
+                std::atomic_ref<int>(counts[idx]).fetch_add(1, std::memory_order_relaxed);
 
-        auto w = static_cast<float>(determinant3x3(matForW));
+            if (!hasPrevious)
+                continue;
+            if (t < static_cast<int>(previousTriangles.size()) && sameTriangle(triangles[t], previousTriangles[t]))
+            {
+                previousToNew[t] = t;
+                continue;
+            }
+            for (int j = previousCellTriangles.begin(aIdx); j < previousCellTriangles.end(aIdx); ++j)
+            {
+                const int previous = previousCellTriangles.indices[j];
+                if (sameTriangle(triangles[t], previousTriangles[previous]))
+                {
+                    previousToNew[previous] = t; // Each previous triangle is found by one triangle at most
+                    break;
+                }
+            }
+        }
+    }, 1024);
+    if (nbrInvalid > 0)
+        std::cerr << "Error: " << nbrInvalid << " triangles have a point not found in the graph." << '\n';
+
+    // Prefix sum of the counts : the start of the fan of each point in the flat arrays
+    cellTriangles.allocate(counts);
+    const int nbrEntries = cellTriangles.offsets.back();
+    nearCellulePointsTriees.assign(nbrEntries, -1);
+    hullNeighbors.assign(nbrPoints, {-1, -1});
+
+    // Position of the point p in the counter-clockwise triangle t : the vertex after it is the next one of the fan, the vertex before it the
+    // previous one
+    auto nextAround = [&](int t, int p) {
+        const std::array<int, 3>& ccw = ccwTriangles[t];
+        return ccw[0] == p ? ccw[1] : ccw[1] == p ? ccw[2] : ccw[0];
+    };
+    auto previousAround = [&](int t, int p) {
+        const std::array<int, 3>& ccw = ccwTriangles[t];
+        return ccw[0] == p ? ccw[2] : ccw[1] == p ? ccw[0] : ccw[1];
+    };
+
+    // Reuse the previous ring of a point whose star did not change : the same number of triangles, all of them still in the triangulation, and
+    // a complete ring (every triangle linked). Its triangles are renumbered and their order checked against the new orientations, only the
+    // circumcenters have moved. The ring starts like a rebuilt one, so both give the same cells
+    std::vector<char> reused(nbrPoints, 0);
+    std::atomic<int>  nbrReused = 0;
+    if (hasPrevious)
+    {
+        threadPool.parallelFor(0, nbrPoints, [&](int pointBegin, int pointEnd) {
+            for (int idxPoint = pointBegin; idxPoint < pointEnd; ++idxPoint)
+            {
+                const int previousBegin = previousCellTriangles.begin(idxPoint);
+                const int previousEnd   = previousCellTriangles.end(idxPoint);
+                const int count         = previousEnd - previousBegin;
+                if (count == 0 || count != cellTriangles.count(idxPoint))
+                    continue;
+
+                // The ring is stored from its first slot, every slot but the last one (open fan on the hull) followed by the next slot
+                bool complete = true;
+                for (int j = previousBegin; j < previousEnd && complete; ++j)
+                    complete = previousToNew[previousCellTriangles.indices[j]] != -1
+                            && (previousCellSuccessors[j] == j + 1 || j + 1 == previousEnd);
+                if (!complete)
+                    continue;
+
+                const int  begin  = cellTriangles.begin(idxPoint);
+                const int* ring   = &previousCellTriangles.indices[previousBegin];
+                bool       linked = true;
+                for (int k = 0; k + 1 < count && linked; ++k)
+                    linked = previousAround(previousToNew[ring[k]], idxPoint) == nextAround(previousToNew[ring[k + 1]], idxPoint);
+                if (!linked)
+                    continue; // Not the same order with the new orientations
+
+                const int  first  = previousToNew[ring[0]];
+                const int  last   = previousToNew[ring[count - 1]];
+                const bool closed = previousAround(last, idxPoint) == nextAround(first, idxPoint);
+                if (closed != (previousCellSuccessors[previousEnd - 1] == previousBegin))
+                    continue; // The fan opened or closed
+
+                // A closed ring starts from its triangle of lowest index, an open fan from its only triangle without predecessor
+                int start = 0;
+                if (closed)
+                {
+                    for (int k = 1; k < count; ++k)
+                    {
+                        if (previousToNew[ring[k]] < previousToNew[ring[start]])
+                            start = k;
+                    }
+                }
+                for (int k = 0; k < count; ++k)
+                {
+                    cellTriangles.indices[begin + k]   = previousToNew[ring[(start + k) % count]];
+                    nearCellulePointsTriees[begin + k] = begin + k + 1;
+                }
+                if (closed)
+                    nearCellulePointsTriees[begin + count - 1] = begin;
+                else
+                {
+                    nearCellulePointsTriees[begin + count - 1] = -1;
+                    hullNeighbors[idxPoint]                    = {nextAround(first, idxPoint), previousAround(last, idxPoint)};
+                }
+                reused[idxPoint] = 1;
+                nbrReused++;
+            }
+        }, 256);
+    }
+    nbrReusedRings = nbrReused;
 
-        Point center(x / w, y / w); // Calculate the center of the circumcircle
-        // std::cout << "Center of circumcircle for triangle with points ("
-        //           << triangle.a->x << ", " << triangle.a->y << "), ("
-        //           << triangle.b->x << ", " << triangle.b->y << "), ("
-        //           << triangle.c->x << ", " << triangle.c->y << ") is at ("
-        //           << center.first << ", " << center.second << ")\n";
+    // Second pass : each triangle takes a slot in the fan of its three vertices, with the two other vertices in counter-clockwise order (the
+    // next and the previous one). The slots are taken in any order, the third pass does not depend on it. The reused rings are skipped
+    std::vector<int> cursor(cellTriangles.offsets.begin(), cellTriangles.offsets.end() - 1); // Next free slot of each fan
+    std::vector<int> fanTriangle(nbrEntries);
+    std::vector<int> fanNext(nbrEntries);
+    std::vector<int> fanPrevious(nbrEntries);
 
-        int aIdx = triangle[0]; // Get the index of the point in the graph
-        int bIdx = triangle[1]; // Get the index of the point in the graph
-        int cIdx = triangle[2]; // Get the index of the point in the graph
+    if (nbrReusedRings < nbrPoints)
+    {
+        threadPool.parallelFor(0, nbrTriangles, [&](int triangleBegin, int triangleEnd) {
+            for (int t = triangleBegin; t < triangleEnd; ++t)
+            {
+                const std::array<int, 3>& ccw = ccwTriangles[t];
+                if (ccw[0] == -1)
+                    continue;
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (reused[ccw[k]])
+                        continue;
+                    const int slot    = std::atomic_ref<int>(cursor[ccw[k]]).fetch_add(1, std::memory_order_relaxed);
+                    fanTriangle[slot] = t;
+                    fanNext[slot]     = ccw[(k + 1) % 3];
+                    fanPrevious[slot] = ccw[(k + 2) % 3];
+                }
+            }
+        }, 1024);
+    }
 
-        if (aIdx == -1 || bIdx == -1 || cIdx == -1)
+    // Third pass, over the points : walk around each point from triangle to triangle. The triangle after (p, next, previous) in counter-clockwise
+    // order is the one whose next vertex is previous, so the ring comes out in order without any angle. Each point only writes its own range
+    threadPool.parallelFor(0, nbrPoints, [&](int pointBegin, int pointEnd) {
+        std::vector<int>  successor; // For each slot of the fan, the slot of the next triangle (-1 on the hull)
+        std::vector<char> hasPredecessor;
+        std::vector<char> visited;
+        for (int idxPoint = pointBegin; idxPoint < pointEnd; ++idxPoint)
         {
-            std::cerr << "Error: Point not found in the graph." << '\n';
-            continue; // Skip this triangle if any point is not found
-        }
+            const int begin = cellTriangles.begin(idxPoint);
+            const int end   = cellTriangles.end(idxPoint);
+            const int count = end - begin;
+            if (count == 0 || reused[idxPoint])
+                continue;
+
+            // The fans have about 6 triangles, a linear search is faster than any index
+            successor.assign(count, -1);
+            hasPredecessor.assign(count, 0);
+            visited.assign(count, 0);
+            for (int s = 0; s < count; ++s)
+            {
+                for (int n = 0; n < count; ++n)
+                {
+                    if (fanNext[begin + n] == fanPrevious[begin + s])
+                    {
+                        successor[s]      = n;
+                        hasPredecessor[n] = 1;
+                        break;
+                    }
+                }
+            }
 
-        nearCellulePoints[aIdx].emplace_back(center); // Add the center to the nearCellulePoints of point a
-        nearCellulePoints[bIdx].emplace_back(center); // Add the center to the nearCellulePoints of point b
-        nearCellulePoints[cIdx].emplace_back(center); // Add the center to the nearCellulePoints of point c
+            // On the convex hull the fan is open : start from the triangle which has no predecessor. Otherwise from the triangle of lowest index,
+            // so the cell does not depend on the order in which the slots were taken
+            int start = -1;
+            for (int s = 0; s < count; ++s)
+            {
+                if (!hasPredecessor[s] && (start == -1 || fanTriangle[begin + s] < fanTriangle[begin + start]))
+                    start = s;
+            }
+            if (start == -1)
+            {
+                start = 0;
+                for (int s = 1; s < count; ++s)
+                {
+                    if (fanTriangle[begin + s] < fanTriangle[begin + start])
+                        start = s;
+                }
+            }
 
-        nearCellulePointsList.emplace_back(center); // Add the center to the nearCellulePointsList
-    }
+            int  out      = begin;
+            int  lastSlot = start;
+            bool closed   = false;
+            for (int s = start; s != -1 && !visited[s];)
+            {
+                visited[s]                   = 1;
+                lastSlot                     = s;
+                cellTriangles.indices[out++] = fanTriangle[begin + s];
+
+                s = successor[s];
+                if (s == start)
+                    closed = true;
+            }
+            const int ringEnd = out;
+
+            // A non-manifold fan (broken triangulation) : the triangles which were not reached are appended without successor
+            for (int s = 0; s < count; ++s)
+            {
+                if (!visited[s])
+                    cellTriangles.indices[out++] = fanTriangle[begin + s];
+            }
+            std::sort(cellTriangles.indices.begin() + ringEnd, cellTriangles.indices.begin() + end);
+
+            for (int i = begin; i + 1 < ringEnd; ++i)
+                nearCellulePointsTriees[i] = i + 1; // Successor of each circumcenter in the cell
+            if (closed)
+                nearCellulePointsTriees[ringEnd - 1] = begin;
+            else
+                hullNeighbors[idxPoint] = {fanNext[begin + start], fanPrevious[begin + lastSlot]}; // The fan is bounded by the hull edges (p, next) and (previous, p)
+        }
+    }, 256);
 }
 
-bool Graphe::hasOtherTriangleForSegment(const std::vector<std::array<Point, 3>>& trianglesPoints, const Point& p1, const Point& p2, const Point& excluded)
+template<typename Precision>
+bool BasicGraphe<Precision>::hasOtherTriangleForSegment(const std::vector<std::array<Point, 3>>& trianglesPoints, const Point& p1, const Point& p2, const Point& excluded)
 {
     for (const auto& triangle : trianglesPoints)
     {
@@ -68,7 +298,8 @@ bool Graphe::hasOtherTriangleForSegment(const std::vector<std::array<Point, 3>>&
     return false;
 }
 
-void Graphe::findBorderPoints()
+template<typename Precision>
+void BasicGraphe<Precision>::findBorderPoints()
 {
 #if 0
     for (auto& point : pointList)
@@ -83,24 +314,35 @@ void Graphe::findBorderPoints()
             point.first  = std::min(point.first, limitX);          // Clamp the point to the limit
             point.second = std::max(point.second, -limitY);        // Clamp the point to the limit
             point.second = std::min(point.second, limitY);         // Clamp the point to the limit
-            idxPointBorder.emplace_back(getIndexFromPoint(point)); // Add the index of the border point to the list
+            pointList.setFlag(getIndexFromPoint(point), PointFlag::Border); // Mark the point as a border point
             continue;                                              // Skip points that are outside the defined limits
         }
     }
 #else
-    for (int i = 0; i < pointList.size(); ++i)
+    if (domain)
     {
-        Point point = pointList[i]; // Get the current point from the graph
+        // Bring the points which left the loaded domain back on its border
+        for (int i = 0; i < static_cast<int>(pointList.size()); ++i)
+        {
+            if (!domain->contains(pointList[i]))
+            {
+                movePoint(i, domain->closestBorderPoint(pointList[i]));
+                pointList.setFlag(i, PointFlag::Border);
+            }
+        }
+        return;
+    }
 
-        float dist = std::sqrt(point.first * point.first + point.second * point.second);
+    for (int i = 0; i < static_cast<int>(pointList.size()); ++i)
+    {
+        Real dist = std::sqrt(static_cast<Real>(pointList.x[i]) * pointList.x[i] + static_cast<Real>(pointList.y[i]) * pointList.y[i]);
         if (dist > radius - 0.001f)
         {
             // Clamp the point to the circle boundary
-            float angle         = std::atan2(point.second, point.first); // Calculate the angle of the point
-            pointList[i].first  = std::cos(angle) * radius;              // Scale the point to the circle boundary
-            pointList[i].second = std::sin(angle) * radius;              // Scale the point to the circle boundary
-            idxPointBorder.emplace_back(i);                              // Add the index of the border point to the list
-            continue;                                                    // Skip points that are outside the defined circle
+            Real angle = std::atan2(static_cast<Real>(pointList.y[i]), static_cast<Real>(pointList.x[i]));                      // Calculate the angle of the point
+            movePoint(i, Point(static_cast<Scalar>(std::cos(angle) * radius), static_cast<Scalar>(std::sin(angle) * radius))); // Scale the point to the circle boundary
+            pointList.setFlag(i, PointFlag::Border);                                                                           // Mark the point as a border point
+            continue;                                                                                        // Skip points that are outside the defined circle
         }
     }
 #endif
@@ -189,11 +431,12 @@ void Graphe::findBorderPoints()
     // }
 }
 
-void Graphe::findBorderPoints_BROKEN_Function()
+template<typename Precision>
+void BasicGraphe<Precision>::findBorderPoints_BROKEN_Function()
 {
     // Calculate the nearest point from a polygon list point doesn't give the neighborhood of the point in a polygon... This function doesn't do what we want.
 
-    for (const auto& center : nearCellulePointsList)
+    for (const auto& center : nearCellulePointsList.toPairs())
     {
         std::cout << "__________________________________________________________\n";
         std::cout << "Center of circumcircle at (" << center.first << ", " << center.second << ")\n";
@@ -203,12 +446,12 @@ void Graphe::findBorderPoints_BROKEN_Function()
             std::make_pair(Point(0.f, 0.f), std::numeric_limits<float>::max())  // Second neighbor initialized to a point at (0,0) with max distance
         };
 
-        for (int i = 0; i < pointList.size(); ++i)
+        for (int i = 0; i < static_cast<int>(pointList.size()); ++i)
         {
             if (!isBorder) // If the center is already determined to be a border point, skip further checks
                 break;
 
-            std::vector<Point> currentCenterList = nearCellulePoints[i];
+            std::vector<Point> currentCenterList = cellVertices(i);
 
             if (std::find(currentCenterList.begin(), currentCenterList.end(), center) != currentCenterList.end())
             {
@@ -345,3 +588,7 @@ void Graphe::findBorderPoints_BROKEN_Function()
     // TO DO:
     // Add the border points to a list or vector for further processing
 }
+
+template struct BasicGraphe<FloatPrecision>;
+template struct BasicGraphe<DoublePrecision>;
+template struct BasicGraphe<MixedPrecision>;
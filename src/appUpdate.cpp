@@ -1,4 +1,5 @@
 #include <math.h>
+#include <chrono>
 #include <numbers>
 #include <random>
 #include "imguiRender.hpp"
@@ -10,31 +11,59 @@ void App::update(GLFWwindow* window, Program& program)
     int height = 0;
     glfwGetWindowSize(window, &width, &height);
 
-    int nbrFlips = 1; // Initialize the number of flips
+    // Collect the iteration which ran in the background since the last frame
+    if (iteration.valid() && iteration.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        waitIteration();
+    }
 
     // get the mouse position
     if (mousePoint)
     {
+        waitIteration(); // The graph can not be modified while an iteration runs
+
         double mouseX = NAN;
         double mouseY = NAN;
         glfwGetCursorPos(window, &mouseX, &mouseY);
-        graphe.pointList[0].first  = (static_cast<float>(mouseX) / static_cast<float>(width)) * 30 - 15.; // Convert mouse position to OpenGL coordinates
-        graphe.pointList[0].second = (static_cast<float>(height - mouseY) / height) * 30 - 15.;           // Convert mouse position to OpenGL coordinates
+        graphe.movePoint(0, Point((static_cast<float>(mouseX) / static_cast<float>(width)) * 30 - 15.,  // Convert mouse position to OpenGL coordinates
+                                  (static_cast<float>(height - mouseY) / height) * 30 - 15.)); // Convert mouse position to OpenGL coordinates
         // position[0].x                          = graphe.pointList[0].first;
         // position[0].y                          = graphe.pointList[0].second;
         // position[0].z                          = 0.f; // Set z to 0 for 2D points
+        graphe.publishSnapshot();
+    }
+    else if (itrCentralisation == 0 && !io.WantCaptureMouse && glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS)
+    {
+        waitIteration();
+
+        // Select the point under the cursor for the CVT energy
+        double mouseX = NAN;
+        double mouseY = NAN;
+        glfwGetCursorPos(window, &mouseX, &mouseY);
+        const Point mouse((static_cast<float>(mouseX) / static_cast<float>(width)) * 30 - 15.,  // Convert mouse position to OpenGL coordinates
+                          (static_cast<float>(height - mouseY) / height) * 30 - 15.); // Convert mouse position to OpenGL coordinates
+
+        graphe.refreshSpatialGrid(); // The points may have been loaded or regenerated since the grid was built
+        const int idx = graphe.spatialGrid.nearest(graphe.pointList, mouse);
+        if (idx != -1 && !graphe.pointList.hasFlag(idx, PointFlag::Fixed) && idx != graphe.currentIdxEnergiePoint)
+        {
+            graphe.currentIdxEnergiePoint = idx;
+            graphe.currentCVTEnergie      = graphe.calcul_CVT_energie(idx); // Calculate the CVT energy for the selected point
+        }
     }
 
+    const std::shared_ptr<const Graphe::Snapshot> snapshot = graphe.snapshot(); // State drawn in this frame, the graph itself may be in the middle of an iteration
+
     if (drawTriangles)
     {
         std::vector<Vertex> vertices;                     // Create a vector to hold the vertices of the triangles
         glm::vec3           currentColor = BLUE;          // Color for the triangles
-        vertices.reserve(graphe.idxTriangles.size() * 3); // Reserve space
-        for (const auto& triangle : graphe.idxTriangles)
+        vertices.reserve(snapshot->triangles.size() * 3); // Reserve space
+        for (const auto& triangle : snapshot->triangles)
         {
-            Point p1 = graphe.pointList[triangle[0]];                                    // Get the first point of the triangle
-            Point p2 = graphe.pointList[triangle[1]];                                    // Get the second point of the triangle
-            Point p3 = graphe.pointList[triangle[2]];                                    // Get the third point of the triangle
+            Point p1 = snapshot->points[triangle[0]];                                    // Get the first point of the triangle
+            Point p2 = snapshot->points[triangle[1]];                                    // Get the second point of the triangle
+            Point p3 = snapshot->points[triangle[2]];                                    // Get the third point of the triangle
             vertices.push_back({glm::vec3{p1.first, p1.second, 0.f}, currentColor, {}}); // Add the first vertex
             vertices.push_back({glm::vec3{p2.first, p2.second, 0.f}, currentColor, {}}); // Add the second vertex
             vertices.push_back({glm::vec3{p2.first, p2.second, 0.f}, currentColor, {}}); // Add the second vertex
@@ -47,30 +76,62 @@ void App::update(GLFWwindow* window, Program& program)
         drawTriangles.draw();                              // Draw the triangles
     }
 
-    if (drawCelluleBorder)
+    if (drawCelluleBorder && snapshot->clippedCells.size() == snapshot->points.size())
     {
-        for (const auto& list : graphe.nearCellulePointsTriees) // Get the list of segments formed by the near cell points
+        // The clipped cells are stored as segments, drawn at once
+        const auto&         cells = snapshot->clippedCells;
+        std::vector<Vertex> vertices;
+        vertices.reserve(cells.x.size());
+        for (std::size_t i = 0; i < cells.x.size(); ++i)
+            vertices.push_back({glm::vec3{cells.x[i], cells.y[i], 0.f}, BLACK, {}});
+        GLobject drawCelluleBorder(vertices, GL_LINES, false);
+        drawCelluleBorder.draw();
+    }
+    else if (drawCelluleBorder)
+    {
+        const auto& cells   = snapshot->cellTriangles;
+        const auto& centers = snapshot->circumcenters;
+        for (int idxCell = 0; idxCell < static_cast<int>(cells.size()); ++idxCell) // Get the list of segments formed by the near cell points
         {
-            std::vector<Vertex> vertices;             // Create a vector to hold the vertices of the segments
-            glm::vec3           currentColor = BLACK; // Color for the segments
-            vertices.reserve(list.size() * 2);        // Reserve space for the segments
-            for (const auto& segment : list)          // Iterate through each segment
+            std::vector<Vertex> vertices;                  // Create a vector to hold the vertices of the segments
+            glm::vec3           currentColor = BLACK;      // Color for the segments
+            vertices.reserve(cells.count(idxCell) * 2);    // Reserve space for the segments
+            for (int i = cells.begin(idxCell); i < cells.end(idxCell); ++i) // Iterate through each segment
             {
-                vertices.push_back({glm::vec3{segment[0].first, segment[0].second, 0.f}, currentColor, {}}); // Add the first point of the segment
-                vertices.push_back({glm::vec3{segment[1].first, segment[1].second, 0.f}, currentColor, {}}); // Add the second point of the segment
+                const int next = snapshot->cellSuccessors[i];
+                if (next == -1)
+                    continue;
+                const int a = cells.indices[i];
+                const int b = cells.indices[next];
+                vertices.push_back({glm::vec3{centers.x[a], centers.y[a], 0.f}, currentColor, {}}); // Add the first point of the segment
+                vertices.push_back({glm::vec3{centers.x[b], centers.y[b], 0.f}, currentColor, {}}); // Add the second point of the segment
             }
             GLobject drawCelluleBorder(vertices, GL_LINES, false); // Draw the segments using
             drawCelluleBorder.draw();                              // Draw the segments
         }
     }
 
+    if (snapshot->domain)
+    {
+        // Outline of the loaded domain
+        std::vector<Vertex> vertices;
+        vertices.reserve(snapshot->domain->edges().size() * 2);
+        for (const auto& edge : snapshot->domain->edges())
+        {
+            vertices.push_back({glm::vec3{edge.a.first, edge.a.second, 0.f}, BLUE, {}});
+            vertices.push_back({glm::vec3{edge.b.first, edge.b.second, 0.f}, BLUE, {}});
+        }
+        GLobject drawDomain(vertices, GL_LINES, false);
+        drawDomain.draw();
+    }
+
     if (drawCircles)
     {
-        for (const auto& circle : graphe.triangleCircles) // Iterate through each circle
+        for (const auto& circle : snapshot->triangleCircles) // Iterate through each circle
         {
-            std::vector<Vertex> vertices;                    // Create a vector to hold the vertices of the circle
-            glm::vec3           currentColor = BLACK;        // Color for the circle
-            vertices.reserve(graphe.triangleCircles.size()); // Reserve space for the circle vertices
+            std::vector<Vertex> vertices;                       // Create a vector to hold the vertices of the circle
+            glm::vec3           currentColor = BLACK;           // Color for the circle
+            vertices.reserve(snapshot->triangleCircles.size()); // Reserve space for the circle vertices
             int nbrIterations = 50;                          // Number of iterations for drawing the circle
 
             vertices.push_back({glm::vec3{circle.first.first + circle.second, circle.first.second, 0.f}, currentColor, {}}); // Add the vertex to the circle
@@ -89,7 +150,7 @@ void App::update(GLFWwindow* window, Program& program)
     }
     if (drawOrientedBox)
     {
-        for (const auto& orientedBox : graphe.allOrientedBoxes) // Iterate through each oriented bounding box
+        for (const auto& orientedBox : snapshot->orientedBoxes) // Iterate through each oriented bounding box
         {
             std::vector<Vertex> vertices;             // Create a vector to hold the vertices of the oriented bounding box
             glm::vec3           currentColor = BLACK; // Color for the oriented bounding box
@@ -121,66 +182,32 @@ void App::update(GLFWwindow* window, Program& program)
 
     if (nbrPointsChanged)
     {
-        graphe.pointList.clear();                   // Clear the previous points
-        graphe.nearCellulePointsList.clear();       // Clear the previous circumcenters
-        graphe.idxPointBorder.clear();              // Clear the previous border points
-        graphe.pointList.reserve(graphe.nbrPoints); // Reserve space for new points
-        graphe.allCircles.clear();                  // Clear the list of circles
-        graphe.energies.clear();                    // Clear the list of energies
-        std::default_random_engine             eng(std::random_device{}());
-        std::uniform_real_distribution<double> rayon(0, graphe.radius - 5.);   // Random radius from 0 to the graph's radius - 1
-        std::uniform_real_distribution<double> angle(0, std::numbers::pi * 2); // 2 * pi
-
-        for (int i = 0; i < graphe.nbrPoints; ++i)
-        {
-            graphe.pointList.emplace_back(
-                rayon(eng) * std::cos(angle(eng)), // Random x coordinate
-                rayon(eng) * std::sin(angle(eng))  // Random y coordinate
-            );                                     // Generate random points in a circle of radius 10
-        }
+        waitIteration(); // The graph can not be modified while an iteration runs
 
-        // add border points to the graph
-        int nbrBorderPoints = 20; // Number of border points
-
-        for (int i = 0; i < nbrBorderPoints; ++i)
-        {
-            float angle = static_cast<float>(i) * (2.f * std::numbers::pi / static_cast<float>(nbrBorderPoints)); // Calculate the angle for each point
-            graphe.pointList.emplace_back(
-                graphe.radius * std::cos(angle), // x coordinate
-                graphe.radius * std::sin(angle)  // y coordinate
-            );
-            graphe.idxPointBorder.push_back(static_cast<int>(graphe.pointList.size() - 1)); // Add the index of the border point to the list
-                                                                                            // Generate points on the boundary of the circle
-        }
-
-        graphe.doDelaunayAndCalculateCenters(); // Perform Delaunay triangulation and calculate centers
-
-        v.clear(); // Clear the vertex vector
-        for (int i = 0; i < graphe.pointList.size(); ++i)
-        {
-            v.push_back({glm::vec3{graphe.pointList[i].first - factorTriangle, graphe.pointList[i].second - factorTriangle, 0.f}, RED, {}});
-            v.push_back({glm::vec3{graphe.pointList[i].first + factorTriangle, graphe.pointList[i].second - factorTriangle, 0.f}, RED, {}});
-            v.push_back({glm::vec3{graphe.pointList[i].first, graphe.pointList[i].second + factorTriangle, 0.f}, RED, {}});
-        }
-        triangleObject->set_vertex_data(v); // Set the vertex data for the triangle object
-
-        v.clear(); // Clear the vertex vector for circumcenters
-        for (int i = 0; i < graphe.nearCellulePointsList.size(); ++i)
-        {
-            v.push_back({glm::vec3{graphe.nearCellulePointsList[i].first - factorTriangle2, graphe.nearCellulePointsList[i].second - factorTriangle2, 0.f}, BLACK, {}}); // Add circumcenter vertices
-            v.push_back({glm::vec3{graphe.nearCellulePointsList[i].first + factorTriangle2, graphe.nearCellulePointsList[i].second - factorTriangle2, 0.f}, BLACK, {}});
-            v.push_back({glm::vec3{graphe.nearCellulePointsList[i].first, graphe.nearCellulePointsList[i].second + factorTriangle2, 0.f}, BLACK, {}}); // Add circumcenter vertices
-        }
-        triangleObjectVoro->set_vertex_data(v); // Set the vertex data for the circumcenter object
+        graphe.generateRandomPoints(graphe.nbrPoints, 20); // Random points and 20 border points
+        graphe.doDelaunayAndCalculateCenters();            // Perform Delaunay triangulation and calculate centers
 
         resetCentralisation();    // Reset the centralisation counter
         nbrPointsChanged = false; // Reset the flag after updating the points
+
+        graphe.publishSnapshot();
+        uploadSnapshot(*graphe.snapshot()); // Set the vertex data of the points and of the circumcenters
     }
 
     render2D(); // Render the ImGui interface
 
-    if (get_itrCentralisation() > 0)
+    if (get_itrCentralisation() > 0 && !iteration.valid())
     {
+        startIteration(); // Run the next iteration while the following frames are drawn from the snapshot
+    }
+}
+
+void App::startIteration()
+{
+    // The modes are copied, the GUI can change them while the iteration runs
+    iteration = std::async(std::launch::async, [this, trueDelaunay = trueDelaunay, flipDelaunay = flipDelaunay, recordEnergy = energyPanelVisible]() {
+        int nbrFlips = 1; // Initialize the number of flips
+
         if (trueDelaunay)
         {
             graphe.centralisation();                // Centralize the points in the graph
@@ -193,43 +220,56 @@ void App::update(GLFWwindow* window, Program& program)
             graphe.doDelaunayFlipVersion(nbrFlips); // Flip triangles
         }
 
-        v.clear(); // Clear the vertex vector
-        for (int i = 0; i < graphe.pointList.size(); ++i)
-        {
-            v.push_back({glm::vec3{graphe.pointList[i].first - factorTriangle, graphe.pointList[i].second - factorTriangle, 0.f}, RED, {}});
-            v.push_back({glm::vec3{graphe.pointList[i].first + factorTriangle, graphe.pointList[i].second - factorTriangle, 0.f}, RED, {}});
-            v.push_back({glm::vec3{graphe.pointList[i].first, graphe.pointList[i].second + factorTriangle, 0.f}, RED, {}});
-        }
-        triangleObject->set_vertex_data(v); // Set the vertex data for the triangle object
+        graphe.nbrCentralisation++; // Increment the number of centralisations applied
 
-        v.clear(); // Clear the vertex vector for circumcenters
-        for (int i = 0; i < graphe.nearCellulePointsList.size(); ++i)
+        if (recordEnergy) // Nobody reads the energies while their panel is collapsed, the moments of the cells may not even be needed
         {
-            v.push_back({glm::vec3{graphe.nearCellulePointsList[i].first - factorTriangle2, graphe.nearCellulePointsList[i].second - factorTriangle2, 0.f}, BLACK, {}}); // Add circumcenter vertices
-            v.push_back({glm::vec3{graphe.nearCellulePointsList[i].first + factorTriangle2, graphe.nearCellulePointsList[i].second - factorTriangle2, 0.f}, BLACK, {}});
-            v.push_back({glm::vec3{graphe.nearCellulePointsList[i].first, graphe.nearCellulePointsList[i].second + factorTriangle2, 0.f}, BLACK, {}}); // Add circumcenter vertices
+            const double energieTotal = graphe.calcul_total_CVT_energie(); // Calculate the total energy of the graph
+
+            if (graphe.energies.size() > 0 && energieTotal > 2 * graphe.energies.back())
+                graphe.energies.emplace_back(graphe.energies.back()); // Store the total energy in the energies vector
+            else
+                graphe.energies.emplace_back(energieTotal); // Store the total energy in the energies vector
         }
-        triangleObjectVoro->set_vertex_data(v); // Set the vertex data for the circumcenter object
 
-        decrease_itrCentralisation();
-        graphe.nbrCentralisation++; // Increment the number of centralisations applied
+        graphe.publishSnapshot(); // Give the new state to the renderer
+    });
+}
 
-        double energieTotal = 0.0; // Initialize the total energy
-        for (int i = 0; i < graphe.pointList.size(); ++i)
-        {
-            Point p        = graphe.pointList[i];                                // Get the current point
-            float distance = std::sqrt(p.first * p.first + p.second * p.second); // Calculate the distance from the origin
-            if (distance < graphe.radius * 0.8f)
-            {
-                energieTotal += graphe.calcul_CVT_energie(i); // Calculate the energy for the current point
-            }
-        }
+void App::waitIteration()
+{
+    if (!iteration.valid())
+        return;
 
-        if (graphe.energies.size() > 0 && energieTotal > 2 * graphe.energies.back())
-            graphe.energies.emplace_back(graphe.energies.back()); // Store the total energy in the energies vector
-        else
-            graphe.energies.emplace_back(energieTotal); // Store the total energy in the energies vector
+    iteration.get();
+    decrease_itrCentralisation();
+    uploadSnapshot(*graphe.snapshot()); // The GL buffers can only be updated from the main thread
+
+    if (itrCentralisation == 0 && energyPanelVisible)
+        graphe.currentCVTEnergie = graphe.calcul_CVT_energie(graphe.currentIdxEnergiePoint); // Calculate the CVT energy for the selected point
+}
+
+void App::uploadSnapshot(const Graphe::Snapshot& snapshot)
+{
+    v.clear(); // Clear the vertex vector
+    for (int i = 0; i < static_cast<int>(snapshot.points.size()); ++i)
+    {
+        v.push_back({glm::vec3{snapshot.points.x[i] - factorTriangle, snapshot.points.y[i] - factorTriangle, 0.f}, RED, {}});
+        v.push_back({glm::vec3{snapshot.points.x[i] + factorTriangle, snapshot.points.y[i] - factorTriangle, 0.f}, RED, {}});
+        v.push_back({glm::vec3{snapshot.points.x[i], snapshot.points.y[i] + factorTriangle, 0.f}, RED, {}});
     }
+    triangleObject->set_vertex_data(v); // Set the vertex data for the triangle object
+
+    v.clear(); // Clear the vertex vector for circumcenters
+    for (int i = 0; i < static_cast<int>(snapshot.circumcenters.size()); ++i)
+    {
+        if (snapshot.circumcenters.hasFlag(i, PointFlag::Degenerate))
+            continue; // Invalid triangle
+        v.push_back({glm::vec3{snapshot.circumcenters.x[i] - factorTriangle2, snapshot.circumcenters.y[i] - factorTriangle2, 0.f}, BLACK, {}}); // Add circumcenter vertices
+        v.push_back({glm::vec3{snapshot.circumcenters.x[i] + factorTriangle2, snapshot.circumcenters.y[i] - factorTriangle2, 0.f}, BLACK, {}});
+        v.push_back({glm::vec3{snapshot.circumcenters.x[i], snapshot.circumcenters.y[i] + factorTriangle2, 0.f}, BLACK, {}}); // Add circumcenter vertices
+    }
+    triangleObjectVoro->set_vertex_data(v); // Set the vertex data for the circumcenter object
 }
 
 void App::init()
@@ -279,10 +319,10 @@ void App::init()
     {
         float angle = static_cast<float>(i) * (2.f * std::numbers::pi / 50.f); // Calculate the angle for each point
         graphe.pointList.emplace_back(
-            graphe.radius * std::cos(angle),                                            // x coordinate
-            graphe.radius * std::sin(angle)                                             // y coordinate
-        );                                                                              // Generate points on the boundary of the circle
-        graphe.idxPointBorder.push_back(static_cast<int>(graphe.pointList.size() - 1)); // Add the index of the border point to the list
+            graphe.radius * std::cos(angle), // x coordinate
+            graphe.radius * std::sin(angle), // y coordinate
+            PointFlag::Border                // Generate points on the boundary of the circle
+        );
     }
 
     graphe.pointList.reserve(points.size()); // Reserve space for points in the graph
@@ -297,21 +337,6 @@ void App::init()
 
     // std::cout << "Number of points: " << graphe.pointList.size() / 2 << std::endl;
 
-    v.clear(); // Clear the vertex vector
-    for (int i = 0; i < graphe.pointList.size(); ++i)
-    {
-        v.push_back({glm::vec3{graphe.pointList[i].first - factorTriangle, graphe.pointList[i].second - factorTriangle, 0.f}, RED, {}});
-        v.push_back({glm::vec3{graphe.pointList[i].first + factorTriangle, graphe.pointList[i].second - factorTriangle, 0.f}, RED, {}});
-        v.push_back({glm::vec3{graphe.pointList[i].first, graphe.pointList[i].second + factorTriangle, 0.f}, RED, {}});
-    }
-    triangleObject->set_vertex_data(v); // Set the vertex data for the triangle object
-
-    v.clear(); // Clear the vertex vector for circumcenters
-    for (int i = 0; i < graphe.nearCellulePointsList.size(); ++i)
-    {
-        v.push_back({glm::vec3{graphe.nearCellulePointsList[i].first - factorTriangle2, graphe.nearCellulePointsList[i].second - factorTriangle2, 0.f}, BLACK, {}}); // Add circumcenter vertices
-        v.push_back({glm::vec3{graphe.nearCellulePointsList[i].first + factorTriangle2, graphe.nearCellulePointsList[i].second - factorTriangle2, 0.f}, BLACK, {}});
-        v.push_back({glm::vec3{graphe.nearCellulePointsList[i].first, graphe.nearCellulePointsList[i].second + factorTriangle2, 0.f}, BLACK, {}}); // Add circumcenter vertices
-    }
-    triangleObjectVoro->set_vertex_data(v); // Set the vertex data for the circumcenter object
+    graphe.publishSnapshot();
+    uploadSnapshot(*graphe.snapshot()); // Set the vertex data of the points and of the circumcenters
 }
\ No newline at end of file
@@ -1,78 +1,162 @@
 #pragma once
 
-#include <Eigen/Dense>
+#include <Eigen/Core>
+#include <array>
+#include <cmath>
 #include <iostream>
 #include <limits>
+#include <span>
 #include <vector>
 
-using Point2D = Eigen::Vector2f;
-using namespace std;
+template<typename T>
+using Point2  = Eigen::Matrix<T, 2, 1>;
+using Point2D = Point2<float>;
 
 // Compute centroid of a set of 2D points
-Point2D computeCentroid(const std::vector<Point2D>& points)
+template<typename T>
+inline Point2<T> computeCentroid(std::span<const Point2<T>> points)
 {
-    Point2D c(0.f, 0.f);
+    Point2<T> c(0, 0);
     for (const auto& p : points)
         c += p;
-    c /= static_cast<float>(points.size());
+    c /= static_cast<T>(points.size());
     return c;
 }
 
-// Oriented Minimum Bounding Box via SVD
-std::vector<Point2D> computeOrientedBoundingBox(const std::vector<Point2D>& points)
+// Corners of the box of the given axis (unit vector) and its normal enclosing the points, in order around the box
+template<typename T>
+inline std::array<Point2<T>, 4> boxAlongAxis(std::span<const Point2<T>> points, const Point2<T>& origin, const Point2<T>& axis)
+{
+    const Point2<T> normal(-axis.y(), axis.x());
+    T               minU = std::numeric_limits<T>::max();
+    T               maxU = -std::numeric_limits<T>::max();
+    T               minV = std::numeric_limits<T>::max();
+    T               maxV = -std::numeric_limits<T>::max();
+    for (const auto& p : points)
+    {
+        const Point2<T> centered = p - origin;
+        const T         u        = axis.dot(centered);
+        const T         v        = normal.dot(centered);
+        minU                     = std::min(minU, u);
+        maxU                     = std::max(maxU, u);
+        minV                     = std::min(minV, v);
+        maxV                     = std::max(maxV, v);
+    }
+
+    return {origin + minU * axis + minV * normal, origin + maxU * axis + minV * normal, origin + maxU * axis + maxV * normal,
+            origin + minU * axis + maxV * normal};
+}
+
+// Oriented bounding box along the principal axes of the points (PCA)
+// The eigenvectors of the 2x2 covariance are in closed form, so nothing is allocated and no iterative solver runs
+template<typename T>
+inline std::array<Point2<T>, 4> computeOrientedBoundingBox(std::span<const Point2<T>> points)
 {
     if (points.size() < 2)
-        return points;
+    {
+        const Point2<T> p = points.empty() ? Point2<T>(0, 0) : points[0];
+        return {p, p, p, p};
+    }
 
-    // 1. Compute centroid
-    Point2D centroid = computeCentroid(points);
+    const Point2<T> centroid = computeCentroid(points);
 
-    // 2. Center the point cloud
-    Eigen::MatrixXf centered(points.size(), 2);
-    for (int i = 0; i < points.size(); ++i)
-        centered.row(i) = points[i] - centroid;
+    // Covariance [[xx, xy], [xy, yy]] of the centered points (the scale does not change the axes)
+    T xx = 0;
+    T xy = 0;
+    T yy = 0;
+    for (const auto& p : points)
+    {
+        const Point2<T> centered = p - centroid;
+        xx += centered.x() * centered.x();
+        xy += centered.x() * centered.y();
+        yy += centered.y() * centered.y();
+    }
 
-    // 3. Compute covariance matrix
-    Eigen::Matrix2f cov = (centered.transpose() * centered) / points.size();
+    // Eigenvector of the largest eigenvalue : (xy, lambda - xx) or (lambda - yy, xy), the longer one for the precision. Both vanish when
+    // the covariance is isotropic, then every axis is principal
+    const T   half   = (xx - yy) / 2;
+    const T   lambda = (xx + yy) / 2 + std::sqrt(half * half + xy * xy);
+    Point2<T> axis   = lambda - xx > lambda - yy ? Point2<T>(xy, lambda - xx) : Point2<T>(lambda - yy, xy);
+    const T   length = axis.norm();
+    axis             = length > 0 ? Point2<T>(axis / length) : Point2<T>(1, 0);
 
-    // 4. SVD (or PCA)
-    Eigen::JacobiSVD<Eigen::Matrix2f> svd(cov, Eigen::ComputeFullU);
-    Eigen::Matrix2f                   rotation = svd.matrixU(); // Columns = principal axes
+    return boxAlongAxis(points, centroid, axis);
+}
 
-    // 5. Rotate all points to align with principal axes
-    std::vector<Point2D> rotatedPoints;
-    for (const auto& p : points)
-        rotatedPoints.push_back(rotation.transpose() * (p - centroid));
+// Smallest area rectangle enclosing the points, with a side on an edge of their convex hull (rotating calipers)
+// The hull is built by gift wrapping in the given buffer (at least as many points as the input), the calipers then walk it once
+template<typename T>
+inline std::array<Point2<T>, 4> computeMinimumAreaBox(std::span<const Point2<T>> points, std::span<Point2<T>> hull)
+{
+    if (points.size() < 3)
+        return computeOrientedBoundingBox(points);
 
-    // 6. Find min/max bounds in rotated space
-    Point2D minPt(std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
-    Point2D maxPt(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+    // Convex hull in counter-clockwise order from the lowest point, without the collinear points
+    std::size_t start = 0;
+    for (std::size_t i = 1; i < points.size(); ++i)
+        if (points[i].y() < points[start].y() || (points[i].y() == points[start].y() && points[i].x() < points[start].x()))
+            start = i;
 
-    for (const auto& p : rotatedPoints)
+    std::size_t hullSize = 0;
+    std::size_t current  = start;
+    do
     {
-        minPt = minPt.cwiseMin(p);
-        maxPt = maxPt.cwiseMax(p);
-    }
+        hull[hullSize++] = points[current];
+        std::size_t next = current == 0 ? 1 : 0;
+        for (std::size_t i = 0; i < points.size(); ++i)
+        {
+            const Point2<T> a     = points[next] - points[current];
+            const Point2<T> b     = points[i] - points[current];
+            const T         cross = a.x() * b.y() - a.y() * b.x();
+            if (cross < 0 || (cross == 0 && b.squaredNorm() > a.squaredNorm()))
+                next = i; // i is on the right of (current, next), or farther on the same line
+        }
+        if (points[next] == points[current])
+            break; // Every point at the same position
+        current = next;
+    } while (current != start && hullSize < points.size());
+
+    if (hullSize < 3)
+        return computeOrientedBoundingBox(points); // Collinear points
 
-    // 7. Define corners in rotated space (axis-aligned box)
-    std::vector<Point2D> boxCorners = {
-        {minPt.x(), minPt.y()},
-        {maxPt.x(), minPt.y()},
-        {maxPt.x(), maxPt.y()},
-        {minPt.x(), maxPt.y()}
-    };
+    // For each edge, the calipers on the farthest point along the edge, across it and against it only move forward
+    auto        at       = [&](std::size_t k) -> const Point2<T>& { return hull[k % hullSize]; };
+    T           bestArea = std::numeric_limits<T>::max();
+    std::size_t bestEdge = 0;
+    std::size_t right    = 1;
+    std::size_t top      = 1;
+    std::size_t left     = 1;
+    for (std::size_t edge = 0; edge < hullSize; ++edge)
+    {
+        const Point2<T> axis = (at(edge + 1) - at(edge)).normalized();
+        const Point2<T> normal(-axis.y(), axis.x());
+        right = std::max(right, edge + 1);
+        while (axis.dot(at(right + 1) - at(right)) > 0)
+            ++right;
+        top = std::max(top, right);
+        while (normal.dot(at(top + 1) - at(top)) > 0)
+            ++top;
+        left = std::max(left, top);
+        while (axis.dot(at(left + 1) - at(left)) < 0)
+            ++left;
 
-    // 8. Rotate box corners back to original space
-    for (auto& corner : boxCorners)
-        corner = rotation * corner + centroid;
+        const T width  = axis.dot(at(right) - at(edge)) - axis.dot(at(left) - at(edge));
+        const T height = normal.dot(at(top) - at(edge));
+        if (width * height < bestArea)
+        {
+            bestArea = width * height;
+            bestEdge = edge;
+        }
+    }
 
-    return boxCorners;
+    const Point2<T> axis = (at(bestEdge + 1) - at(bestEdge)).normalized();
+    return boxAlongAxis(std::span<const Point2<T>>(hull.data(), hullSize), at(bestEdge), axis);
 }
 
 // Debug print
-void printBox(const std::vector<Point2D>& box)
+inline void printBox(const std::vector<Point2D>& box)
 {
-    cout << "Oriented Bounding Box Corners:\n";
+    std::cout << "Oriented Bounding Box Corners:\n";
     for (const auto& p : box)
-        cout << "(" << p.x() << ", " << p.y() << ")\n";
+        std::cout << "(" << p.x() << ", " << p.y() << ")\n";
 }
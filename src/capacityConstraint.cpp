@@ -0,0 +1,217 @@
+#include <Eigen/Sparse>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <tuple>
+#include <vector>
+#include "LlyodCentralisation.hpp"
+
+// Largest relative gap between the masses of the cells and their common target, and the smallest mass
+template<typename CellMoments, typename Real>
+static std::pair<Real, Real> massError(const std::vector<CellMoments>& moments, Real target)
+{
+    Real error   = 0;
+    Real minMass = moments.empty() ? Real(0) : moments[0].mass;
+    for (const CellMoments& cell : moments)
+    {
+        error   = std::max(error, std::abs(cell.mass - target) / target);
+        minMass = std::min(minMass, cell.mass);
+    }
+    return {error, minMass};
+}
+
+template<typename Precision>
+int BasicGraphe<Precision>::solveCapacityWeights()
+{
+    capacitySteps = 0;
+    capacityError = 0;
+
+    // The masses of the cells only partition the domain once the cells are clipped, the hull cells being unbounded otherwise
+    const int nbrPoints = static_cast<int>(pointList.size());
+    if (!clipCells || nbrPoints == 0)
+        return 0;
+
+    // The masses are read after each triangulation
+    auto rebuildCells = [this] {
+        triangulateAndBuildCells();
+        ensureCellMoments();
+    };
+
+    if (!hasPowerWeights())
+    {
+        powerWeights.resize(nbrPoints, 0); // New points start with the weight of a Voronoi cell
+        triangulateAndBuildCells();
+    }
+    ensureCellMoments();
+
+    Real totalMass = 0;
+    for (const CellMoments& cell : cellMoments)
+        totalMass += cell.mass;
+    const Real target = totalMass / nbrPoints;
+    if (!(target > 0))
+        return 0;
+
+    const Domain<Scalar>& clipDomain = clippingDomain();
+    const Real            farDistance =
+        4 * (std::abs(static_cast<Real>(clipDomain.maxX()) - clipDomain.minX()) + std::abs(static_cast<Real>(clipDomain.maxY()) - clipDomain.minY()));
+
+    // Integral of the density along the part of the segment (a, b) inside the domain : Simpson on each piece, exact for the uniform density
+    std::vector<double> intervals;
+    auto                massAlong = [&](Real ax, Real ay, Real bx, Real by) {
+        intervals.clear();
+        clipDomain.insideIntervals(Point(static_cast<Scalar>(ax), static_cast<Scalar>(ay)), Point(static_cast<Scalar>(bx), static_cast<Scalar>(by)), intervals);
+        const double length = std::hypot(static_cast<double>(bx) - ax, static_cast<double>(by) - ay);
+        double       mass   = 0;
+        for (std::size_t k = 0; k + 1 < intervals.size(); k += 2)
+        {
+            const double t0 = intervals[k];
+            const double t1 = intervals[k + 1];
+            if (density.empty())
+            {
+                mass += (t1 - t0) * length;
+                continue;
+            }
+            auto rho = [&](double t) { return density.value(ax + t * (bx - ax), ay + t * (by - ay)); };
+            mass += (t1 - t0) * length * (rho(t0) + 4 * rho((t0 + t1) / 2) + rho(t1)) / 6;
+        }
+        return mass;
+    };
+
+    std::vector<Eigen::Triplet<double>> triplets;
+    Eigen::VectorXd                     residual(nbrPoints);
+    Eigen::SparseMatrix<double>         jacobian(nbrPoints, nbrPoints);
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver;
+
+    auto [error, minMass] = massError(cellMoments, target);
+    if (!(minMass > 0))
+    {
+        // The points moved too far for the previous weights and some cells collapsed : a hidden point has no edge, so the Newton steps
+        // could not grow it back. The Voronoi diagram (null weights) hides no point
+        powerWeights.assign(nbrPoints, 0);
+        rebuildCells();
+        std::tie(error, minMass) = massError(cellMoments, target);
+    }
+
+    for (; capacitySteps < capacityMaxSteps && error > capacityTolerance; ++capacitySteps)
+    {
+        // Jacobian of the masses in the weights : raising w_j moves the edge between the cells i and j towards i at the speed
+        // 1 / (2 |p_i - p_j|), so dm_i/dw_j = -rho(edge) / (2 |p_i - p_j|) and each row sums to zero (a graph Laplacian)
+        triplets.clear();
+        auto addEdge = [&](int i, int j, double edgeMass) {
+            const double distance = std::hypot(static_cast<double>(pointList.x[i]) - pointList.x[j], static_cast<double>(pointList.y[i]) - pointList.y[j]);
+            if (!(edgeMass > 0) || !(distance > 0))
+                return;
+            const double c = edgeMass / (2 * distance);
+            triplets.emplace_back(i, j, -c);
+            triplets.emplace_back(j, i, -c);
+            triplets.emplace_back(i, i, c);
+            triplets.emplace_back(j, j, c);
+        };
+
+        for (int i = 0; i < nbrPoints; ++i)
+        {
+            // Edges of the power diagram between two consecutive vertices of the ring, shared with the other vertex of both triangles. Each
+            // edge is in the rings of its two points, it is added from the lower one
+            const int begin = cellTriangles.begin(i);
+            const int end   = cellTriangles.end(i);
+            for (int slot = begin; slot < end; ++slot)
+            {
+                const int next = nearCellulePointsTriees[slot];
+                if (next == -1)
+                    continue;
+                const std::array<int, 3>& t1       = idxTriangles[cellTriangles.indices[slot]];
+                const std::array<int, 3>& t2       = idxTriangles[cellTriangles.indices[next]];
+                int                       neighbor = -1;
+                for (const int a : t1)
+                    if (a != i && (a == t2[0] || a == t2[1] || a == t2[2]))
+                        neighbor = a;
+                if (neighbor <= i)
+                    continue;
+                const int a = cellTriangles.indices[slot];
+                const int b = cellTriangles.indices[next];
+                addEdge(i, neighbor, massAlong(nearCellulePointsList.x[a], nearCellulePointsList.y[a], nearCellulePointsList.x[b], nearCellulePointsList.y[b]));
+            }
+
+            // On the convex hull, the edge with the next point of the hull is a ray from the first vertex of the ring along the outward normal
+            const int hullNext = hullNeighbors[i][0];
+            if (hullNext != -1 && begin < end)
+            {
+                const Real dx     = static_cast<Real>(pointList.x[hullNext]) - pointList.x[i];
+                const Real dy     = static_cast<Real>(pointList.y[hullNext]) - pointList.y[i];
+                const Real length = std::sqrt(dx * dx + dy * dy);
+                const int  first  = cellTriangles.indices[begin];
+                const Real fx     = nearCellulePointsList.x[first];
+                const Real fy     = nearCellulePointsList.y[first];
+                if (length > 0)
+                    addEdge(i, hullNext, massAlong(fx, fy, fx + farDistance * dy / length, fy - farDistance * dx / length));
+            }
+        }
+
+        jacobian.setFromTriplets(triplets.begin(), triplets.end());
+
+        // The masses do not change when every weight is raised by the same amount : the Laplacian is singular along the constant vector,
+        // a tiny diagonal makes it definite and the mean of the step is removed. A point without edge (hidden) keeps its weight
+        double trace = 0;
+        for (int i = 0; i < nbrPoints; ++i)
+        {
+            residual[i] = target - cellMoments[i].mass;
+            trace += jacobian.coeff(i, i);
+        }
+        residual.array() -= residual.mean();
+        const double regularisation = 1e-10 * trace / nbrPoints;
+        for (int i = 0; i < nbrPoints; ++i)
+        {
+            if (jacobian.coeff(i, i) == 0)
+            {
+                jacobian.coeffRef(i, i) = 1;
+                residual[i]             = 0;
+            }
+            else
+            {
+                jacobian.coeffRef(i, i) += regularisation;
+            }
+        }
+
+        solver.compute(jacobian);
+        if (solver.info() != Eigen::Success)
+        {
+            std::cerr << "Capacity constraint: the Jacobian of the masses could not be factorized.\n";
+            break;
+        }
+        Eigen::VectorXd step = solver.solve(residual);
+        step.array() -= step.mean();
+
+        // Damped Newton : halve the step until no cell collapses and the error decreases enough, each try being a new triangulation
+        const std::vector<Real> startWeights = powerWeights;
+        const Real              minAllowed   = std::min(minMass, target) / 2;
+        bool                    accepted     = false;
+        for (Real alpha = 1; alpha > Real(1e-3); alpha /= 2)
+        {
+            for (int i = 0; i < nbrPoints; ++i)
+                powerWeights[i] = startWeights[i] + static_cast<Real>(alpha * step[i]);
+            rebuildCells();
+
+            const auto [tryError, tryMinMass] = massError(cellMoments, target);
+            if (tryMinMass >= minAllowed && tryError <= (1 - alpha / 2) * error)
+            {
+                error    = tryError;
+                minMass  = tryMinMass;
+                accepted = true;
+                break;
+            }
+        }
+        if (!accepted)
+        {
+            powerWeights = startWeights; // The last weights which improved the masses
+            rebuildCells();
+            break;
+        }
+    }
+
+    capacityError = error;
+    return capacitySteps;
+}
+
+template struct BasicGraphe<FloatPrecision>;
+template struct BasicGraphe<DoublePrecision>;
+template struct BasicGraphe<MixedPrecision>;
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <numbers>
+#include <span>
+#include <vector>
+#include "LlyodCentralisation.hpp"
+#include "domainClipping.hpp"
+
+// Number of edges of the polygon approximating the disc when no domain is loaded
+constexpr int discSegments = 128;
+
+template<typename Precision>
+const Domain<typename BasicGraphe<Precision>::Scalar>& BasicGraphe<Precision>::clippingDomain()
+{
+    if (domain)
+        return *domain;
+
+    // The first vertex of the disc is (radius, 0), so a change of the radius is seen on the bounding box
+    if (!discDomain || discDomain->maxX() != static_cast<Scalar>(radius))
+    {
+        discDomain = std::make_shared<const Domain<Scalar>>(Domain<Scalar>::disc(static_cast<Scalar>(radius), discSegments));
+        clippingGeneration++; // The stages built on the previous disc are stale
+    }
+    return *discDomain;
+}
+
+template<typename Precision>
+bool BasicGraphe<Precision>::loadDomain(const std::string& path)
+{
+    Domain<Scalar> loaded;
+    if (!loaded.load(path))
+        return false;
+
+    domain = std::make_shared<const Domain<Scalar>>(std::move(loaded));
+    clippingGeneration++;
+    std::cout << "Domain loaded from " << path << " : " << domain->rings().size() << " rings, " << domain->edges().size() << " edges\n";
+    return true;
+}
+
+template<typename Precision>
+void BasicGraphe<Precision>::ensureClippedCells()
+{
+    clippingDomain(); // Builds the disc again (a new clippingGeneration) if the radius changed
+    if (clippedCellsInputs != StageInputs{cellsGeneration, clippingGeneration, 0})
+        clipCellsToDomain();
+}
+
+template<typename Precision>
+void BasicGraphe<Precision>::clipCellsToDomain()
+{
+    const Domain<Scalar>& clipDomain = clippingDomain(); // First : building the disc bumps clippingGeneration
+    clippedCellsInputs               = {cellsGeneration, clippingGeneration, 0}; // The clipped cells do not depend on the density
+    clippedCells.startLists();
+    if (!clipCells)
+        return;
+
+    const int nbrPoints = static_cast<int>(pointList.size());
+    clippedCells.x.reserve(cellTriangles.indices.size() + nbrPoints); // The clipped cells have about the size of the Voronoi cells
+    clippedCells.y.reserve(cellTriangles.indices.size() + nbrPoints);
+
+    std::vector<RealPoint<Real>> polygon; // Scratch buffers reused for every cell
+    std::vector<RealPoint<Real>> clipped;
+    std::vector<int>             candidates;
+    std::vector<Real>            cuts;
+
+    // Size of the domain, to close the unbounded cells beyond it
+    const Real domainSize = std::max({std::abs(static_cast<Real>(clipDomain.minX())), std::abs(static_cast<Real>(clipDomain.maxX())),
+                                      std::abs(static_cast<Real>(clipDomain.minY())), std::abs(static_cast<Real>(clipDomain.maxY()))});
+
+    for (int i = 0; i < nbrPoints; ++i)
+    {
+        polygon.clear();
+        const int  begin = cellTriangles.begin(i);
+        const int  end   = cellTriangles.end(i);
+        const Real px    = pointList.x[i];
+        const Real py    = pointList.y[i];
+
+        // The ring of the cell, from its first circumcenter along the successors
+        Real farthest = 0;
+        for (int j = begin; j != -1 && j < end;)
+        {
+            const Real cx = nearCellulePointsList.x[cellTriangles.indices[j]];
+            const Real cy = nearCellulePointsList.y[cellTriangles.indices[j]];
+            polygon.emplace_back(cx, cy);
+            farthest = std::max(farthest, std::sqrt(cx * cx + cy * cy));
+            j        = nearCellulePointsTriees[j];
+            if (j == begin)
+                break;
+        }
+
+        const auto [hullNext, hullPrevious] = hullNeighbors[i];
+        if (hullNext != -1 && hullPrevious != -1 && !polygon.empty())
+        {
+            // Cell of a point of the convex hull : it is unbounded, between the bisectors of the two hull edges (previous, p) and (p, next).
+            // It is closed far enough to contain its part of the domain, following the outward normals of the edges
+            auto outwardNormal = [](Real fromX, Real fromY, Real toX, Real toY) {
+                const Real dx = toX - fromX;
+                const Real dy = toY - fromY;
+                const Real l  = std::sqrt(dx * dx + dy * dy);
+                return RealPoint<Real>(dy / l, -dx / l); // Right side of the edge, the hull being counter-clockwise
+            };
+            const RealPoint<Real> normalIn  = outwardNormal(pointList.x[hullPrevious], pointList.y[hullPrevious], px, py); // Edge of the last circumcenter
+            const RealPoint<Real> normalOut = outwardNormal(px, py, pointList.x[hullNext], pointList.y[hullNext]);         // Edge of the first circumcenter
+
+            const RealPoint<Real> first = polygon.front();
+            const RealPoint<Real> last  = polygon.back();
+
+            // The border of the triangulation may be slightly reflex at p (slivers dropped by the triangulation) : the two rays then meet, and
+            // the cell is closed at their intersection
+            const Real            turn = cross(normalIn, normalOut);
+            const RealPoint<Real> lastToFirst(first.first - last.first, first.second - last.second);
+            const Real            s = turn < 0 ? cross(lastToFirst, normalOut) / turn : 0; // Position of the intersection on the ray of the last circumcenter
+            const Real            t = turn < 0 ? cross(lastToFirst, normalIn) / turn : 0;  // Position of the intersection on the ray of the first circumcenter
+            if (s > 0 && t > 0)
+            {
+                polygon.emplace_back(last.first + s * normalIn.first, last.second + s * normalIn.second);
+            }
+            else
+            {
+                RealPoint<Real> middle(normalIn.first + normalOut.first, normalIn.second + normalOut.second);
+                const Real      middleNorm = std::sqrt(middle.first * middle.first + middle.second * middle.second);
+                middle = middleNorm > 0 ? RealPoint<Real>(middle.first / middleNorm, middle.second / middleNorm) : normalIn;
+
+                const Real            farDistance = 4 * (2 * domainSize + farthest + std::sqrt(px * px + py * py));
+                const RealPoint<Real> farLast(last.first + farDistance * normalIn.first, last.second + farDistance * normalIn.second);
+                const RealPoint<Real> farFirst(first.first + farDistance * normalOut.first, first.second + farDistance * normalOut.second);
+                const RealPoint<Real> farMiddle((farLast.first + farFirst.first) / 2 + farDistance * middle.first, // Beyond both far points, to stay convex
+                                                (farLast.second + farFirst.second) / 2 + farDistance * middle.second);
+                polygon.push_back(farLast);
+                polygon.push_back(farMiddle);
+                polygon.push_back(farFirst);
+            }
+        }
+
+        if (polygon.size() >= 3)
+        {
+            clipped.clear();
+            clipConvexPolygonToDomain<Real, Scalar>(polygon, clipDomain, candidates, cuts, clipped);
+            for (const auto& p : clipped)
+                clippedCells.append(Point(static_cast<Scalar>(p.first), static_cast<Scalar>(p.second)));
+        }
+        clippedCells.endList(); // An empty list if the cell could not be built or is outside the domain
+    }
+}
+
+template<typename Precision>
+bool BasicGraphe<Precision>::loadMetric(const std::string& path)
+{
+    MetricField<Scalar> loaded;
+    if (!loaded.load(path))
+        return false;
+
+    metric = std::move(loaded);
+    std::cout << "Metric field loaded from " << path << " : " << metric.width() << " x " << metric.height() << " nodes\n";
+    return true;
+}
+
+template<typename Precision>
+typename BasicGraphe<Precision>::CellMoments BasicGraphe<Precision>::computeAnisotropicCell(int idxPoint, const Domain<Scalar>& clipDomain, AnisotropicScratch& scratch) const
+{
+    // The metric is constant over the cell, the one of its point (local affine approximation of the Riemannian metric). With the metric M
+    // of p for both points, the points closer to p than to q are the half-plane 2 (q - p)^T M (x - p) <= (q - p)^T M (q - p), so the cell is
+    // the intersection of the half-planes of the neighbors, and its centroid in the metric is its usual centroid
+    const Real px     = pointList.x[idxPoint];
+    const Real py     = pointList.y[idxPoint];
+    const auto tensor = metric.at(px, py);
+    const Real ma     = static_cast<Real>(tensor.a);
+    const Real mb     = static_cast<Real>(tensor.b);
+    const Real mc     = static_cast<Real>(tensor.c);
+
+    // The Delaunay neighbors and theirs : a stretched cell reaches points which are not Delaunay neighbors of p
+    std::vector<int>& neighbors = scratch.neighbors;
+    neighbors.clear();
+    for (const int n : pointsAdjacentsIdx[idxPoint])
+    {
+        neighbors.push_back(n);
+        for (const int m : pointsAdjacentsIdx[n])
+            neighbors.push_back(m);
+    }
+    std::sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+
+    // Start from the bounding box of the domain, relative to p
+    std::vector<RealPoint<Real>>& polygon = scratch.polygon;
+    std::vector<RealPoint<Real>>& clipped = scratch.clipped;
+    const Real                    minX    = static_cast<Real>(clipDomain.minX()) - px;
+    const Real                    minY    = static_cast<Real>(clipDomain.minY()) - py;
+    const Real                    maxX    = static_cast<Real>(clipDomain.maxX()) - px;
+    const Real                    maxY    = static_cast<Real>(clipDomain.maxY()) - py;
+    polygon.assign({{minX, minY}, {maxX, minY}, {maxX, maxY}, {minX, maxY}});
+
+    // Sutherland-Hodgman on each half-plane n.y <= h, with n = 2 M (q - p) and h = (q - p)^T M (q - p)
+    for (const int q : neighbors)
+    {
+        if (q == idxPoint || polygon.size() < 3)
+            continue;
+        const Real dx = static_cast<Real>(pointList.x[q]) - px;
+        const Real dy = static_cast<Real>(pointList.y[q]) - py;
+        const Real nx = 2 * (ma * dx + mb * dy);
+        const Real ny = 2 * (mb * dx + mc * dy);
+        const Real h  = (nx * dx + ny * dy) / 2;
+        if (!(h > 0))
+            continue; // Same position as p
+
+        clipped.clear();
+        const int n = static_cast<int>(polygon.size());
+        for (int k = 0; k < n; ++k)
+        {
+            const RealPoint<Real>& a     = polygon[k];
+            const RealPoint<Real>& b     = polygon[(k + 1) % n];
+            const Real             sideA = nx * a.first + ny * a.second - h;
+            const Real             sideB = nx * b.first + ny * b.second - h;
+            if (sideA <= 0)
+                clipped.push_back(a);
+            if ((sideA < 0 && sideB > 0) || (sideA > 0 && sideB < 0))
+            {
+                const Real t = sideA / (sideA - sideB);
+                clipped.emplace_back(a.first + t * (b.first - a.first), a.second + t * (b.second - a.second));
+            }
+        }
+        std::swap(polygon, clipped);
+    }
+
+    CellMoments moments;
+    if (polygon.size() < 3)
+        return moments;
+
+    // The border of the cell as oriented segments : the edges of the polygon, or its pieces inside the domain
+    clipped.clear();
+    if (clipCells)
+    {
+        for (RealPoint<Real>& p : polygon)
+            p = RealPoint<Real>(p.first + px, p.second + py);
+        clipConvexPolygonToDomain<Real, Scalar>(polygon, clipDomain, scratch.candidates, scratch.cuts, clipped);
+        for (RealPoint<Real>& p : clipped)
+            p = RealPoint<Real>(p.first - px, p.second - py);
+    }
+    else
+    {
+        for (std::size_t k = 0; k < polygon.size(); ++k)
+        {
+            clipped.push_back(polygon[k]);
+            clipped.push_back(polygon[(k + 1) % polygon.size()]);
+        }
+    }
+
+    // Fan of triangles (p, u, v) over the segments : area, first moments and second moments relative to p
+    Real doubleArea = 0;
+    Real momentX    = 0;
+    Real momentY    = 0;
+    Real xx         = 0;
+    Real xy         = 0;
+    Real yy         = 0;
+    for (std::size_t k = 0; k + 1 < clipped.size(); k += 2)
+    {
+        const RealPoint<Real>& u     = clipped[k];
+        const RealPoint<Real>& v     = clipped[k + 1];
+        const Real             cross = u.first * v.second - u.second * v.first;
+        doubleArea += cross;
+        momentX += (u.first + v.first) * cross;
+        momentY += (u.second + v.second) * cross;
+        xx += cross * (u.first * u.first + u.first * v.first + v.first * v.first);
+        yy += cross * (u.second * u.second + u.second * v.second + v.second * v.second);
+        xy += cross * (2 * u.first * u.second + u.first * v.second + v.first * u.second + 2 * v.first * v.second);
+    }
+
+    moments.area   = doubleArea / 2;
+    moments.mass   = moments.area;
+    moments.energy = (ma * xx + mb * xy + mc * yy) / 12; // Integral of (x - p)^T M (x - p) : the integral of xy is xy / 24, counted twice
+    if (doubleArea > 0)
+        moments.centroid = Point(static_cast<Scalar>(px + momentX / (3 * doubleArea)), static_cast<Scalar>(py + momentY / (3 * doubleArea)));
+    return moments;
+}
+
+template struct BasicGraphe<FloatPrecision>;
+template struct BasicGraphe<DoublePrecision>;
+template struct BasicGraphe<MixedPrecision>;
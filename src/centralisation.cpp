@@ -1,81 +1,91 @@
 #include <complex.h>
 #include <algorithm>
 #include <array>
+#include <cstddef>
 #include <chrono>
 #include <cmath>
 #include <iostream>
+#include <memory_resource>
 #include <numbers>
+#include <random>
+#include <span>
 #include "LlyodCentralisation.hpp"
 #include "boundingBox.hpp"
 #include "utils.hpp"
 
-using Point = std::pair<float, float>; // Représente un point (x, y)
+constexpr double goldenAngle           = 2.399963229728653; // Successive directions turned by it never line up, so copies of a point spread out
+constexpr int    maxSeparationAttempts = 8;                 // Directions tried inside the domain for a near-duplicate point, then as many anywhere
 
 // Fonction utilitaire pour calculer le centre (barycentre simple) des points
-Point computeCenter(const std::vector<Point>& points)
+template<typename Real, typename T>
+std::pair<T, T> computeCenter(std::span<const std::pair<T, T>> points)
 {
-    float cx = 0.0f;
-    float cy = 0.0f;
+    Real cx = 0.0;
+    Real cy = 0.0;
     for (const auto& p : points)
     {
         cx += p.first;
         cy += p.second;
     }
-    cx /= static_cast<float>(points.size());
-    cy /= static_cast<float>(points.size());
-    return {cx, cy};
+    cx /= static_cast<Real>(points.size());
+    cy /= static_cast<Real>(points.size());
+    return {static_cast<T>(cx), static_cast<T>(cy)};
 }
 
 // Fonction pour trier les points dans l'ordre antihoraire autour du centre
-void sortPointsCCW(std::vector<Point>& points)
+// Only for the k-nearest points, which have no topology : the Voronoi cells come out of the triangle fans already in order
+template<typename Real, typename T>
+void sortPointsCCW(std::span<std::pair<T, T>> points)
 {
-    Point center = computeCenter(points);
-    std::sort(points.begin(), points.end(), [center](const Point& a, const Point& b) {
-        float angleA = std::atan2(a.second - center.second, a.first - center.first);
-        float angleB = std::atan2(b.second - center.second, b.first - center.first);
+    const std::pair<T, T> center = computeCenter<Real, T>(points);
+    std::sort(points.begin(), points.end(), [center](const std::pair<T, T>& a, const std::pair<T, T>& b) {
+        T angleA = std::atan2(a.second - center.second, a.first - center.first);
+        T angleB = std::atan2(b.second - center.second, b.first - center.first);
         return angleA < angleB;
     });
 }
 
 // Calcule le centroïde d'un polygone 2D
-Point computeCentroid(const std::vector<Point>& vertices)
+template<typename Real, typename T>
+std::pair<T, T> computeCentroid(std::span<const std::pair<T, T>> vertices)
 {
-    double area = 0.0;
-    double cx   = 0.0;
-    double cy   = 0.0;
-    size_t n    = vertices.size();
+    Real      area = 0.0;
+    Real      cx   = 0.0;
+    Real      cy   = 0.0;
+    const int n    = static_cast<int>(vertices.size());
 
     for (int i = 0; i < n; ++i)
     {
-        const Point& p0 = vertices[i];
-        const Point& p1 = vertices[(i + 1) % n];
+        const std::pair<T, T>& p0 = vertices[i];
+        const std::pair<T, T>& p1 = vertices[(i + 1) % n];
 
-        double cross = p0.first * p1.second - p1.first * p0.second;
+        Real cross = static_cast<Real>(p0.first) * p1.second - static_cast<Real>(p1.first) * p0.second;
         area += cross;
-        cx += (p0.first + p1.first) * cross;
-        cy += (p0.second + p1.second) * cross;
+        cx += (static_cast<Real>(p0.first) + p1.first) * cross;
+        cy += (static_cast<Real>(p0.second) + p1.second) * cross;
     }
 
     area *= 0.5;
     cx /= (6.0 * area);
     cy /= (6.0 * area);
 
-    return {cx, cy};
+    return {static_cast<T>(cx), static_cast<T>(cy)};
 }
 
-Point squareCenter(const std::vector<Point>& points)
+template<typename T>
+std::pair<T, T> squareCenter(std::span<const std::pair<T, T>> points)
 {
     if (points.size() < 3)
     {
         std::cerr << "Not enough points to form a square. Returning the first point as center.\n";
-        return points.empty() ? Point{0, 0} : points[0];
+        return points.empty() ? std::pair<T, T>{0, 0} : points[0];
     }
 
     // Calculate the center of the square formed by the points
-    float minX = points[0].first;
-    float maxX = points[0].first;
-    float minY = points[0].second;
-    float maxY = points[0].second;
+    T minX = points[0].first;
+    T maxX = points[0].first;
+    T minY = points[0].second;
+    T maxY = points[0].second;
 
     for (const auto& p : points)
     {
@@ -86,239 +96,438 @@ Point squareCenter(const std::vector<Point>& points)
     }
 
     // Return the center of the square
-    return {(minX + maxX) / 2.0f, (minY + maxY) / 2.0f};
+    return {(minX + maxX) / 2, (minY + maxY) / 2};
 }
 
-void Graphe::centralisation()
+template<typename Precision>
+void BasicGraphe<Precision>::centralisation()
 {
     allCircles.clear();       // Clear the list of circles before centralisation
     allOrientedBoxes.clear(); // Clear the list of oriented boxes before centralisation
 
+    // Every temporary of this iteration is allocated in the arena, which is rewound here instead of freeing each vector
+    centralisationArena.reset();
+    std::pmr::memory_resource* arena = &centralisationArena;
+
+    refreshSpatialGrid(); // Take the points moved since the last iteration into account
+
+    const Scalar* px = pointList.x.data();
+    const Scalar* py = pointList.y.data();
+
     if (kNearest)
     {
-        kNearestPoints.clear();                  // Clear the list of k-nearest points before centralisation
-        kNearestPoints.resize(pointList.size()); // Resize to match the number of points in pointList
-        for (int i = 0; i < pointList.size(); ++i)
-        {
-            int   compteur = 0;            // Counter for the number of k-nearest points found
-            Point point    = pointList[i]; // Get the current point from the graph
-            while (compteur < k)
+        // Every point gets the same number of neighbors : k, or all the other points if the graph is smaller
+        const int nbrNearest = std::min(k, static_cast<int>(pointList.size()) - 1);
+        kNearestPoints.allocate(std::pmr::vector<int>(pointList.size(), nbrNearest, arena));
+
+        // The queries only read the grid and each point writes its own slots, so they run in parallel. The points are cut in one band per
+        // thread, each band reusing its buffers of the previous iterations
+        const int nbrPoints = static_cast<int>(pointList.size());
+        const int nbrBands  = std::max(1, std::min(threadPool.size(), nbrPoints / 256));
+        const int bandSize  = (nbrPoints + nbrBands - 1) / nbrBands;
+        if (static_cast<int>(kNearestScratch.size()) < nbrBands)
+            kNearestScratch.resize(nbrBands);
+        threadPool.parallelFor(0, nbrBands, [&](int bandBegin, int bandEnd) {
+            for (int band = bandBegin; band < bandEnd; ++band)
             {
-                float minDistance = std::numeric_limits<float>::max();
-                Point closestPoint;
-                for (const auto& neighbor : pointList)
-                {
-                    if (std::find(kNearestPoints[i].begin(), kNearestPoints[i].end(), neighbor) != kNearestPoints[i].end())
-                    {
-                        float d = distance(neighbor, point);
-                        if (d < minDistance)
-                        {
-                            minDistance  = d;
-                            closestPoint = neighbor;
-                        }
-                    }
-                }
-                if (minDistance < 10000) // Check if the closest point is valid
-                {
-                    kNearestPoints[i].push_back(closestPoint); // Add the closest point to the k-nearest points
-                    compteur++;                                // Increment the counter for k-nearest points
-                }
-                else
+                KNearestScratch& scratch = kNearestScratch[band];
+                for (int i = band * bandSize; i < std::min(nbrPoints, (band + 1) * bandSize); ++i)
                 {
-                    continue; // Break if no valid closest point is found
+                    spatialGrid.kNearest(pointList, Point{px[i], py[i]}, nbrNearest, scratch.nearest, scratch.candidates, i); // The closest points, the point itself excluded
+                    int slot = kNearestPoints.begin(i);
+                    for (const int idx : scratch.nearest)
+                        kNearestPoints.set(slot++, Point{px[idx], py[idx]}); // Add the closest point to the k-nearest points
                 }
             }
-        }
+        });
     }
 
-    for (int i = 0; i < pointList.size(); ++i)
-    {
-        if (std::find(idxPointBorder.begin(), idxPointBorder.end(), i) != idxPointBorder.end())
+    // Copy the adjacent points of i in neighbors
+    auto gatherAdjacents = [&](std::pmr::vector<Point>& neighbors, int i) {
+        neighbors.reserve(pointsAdjacentsIdx[i].size());
+        for (const int idx : pointsAdjacentsIdx[i])
+            neighbors.emplace_back(px[idx], py[idx]);
+    };
+
+    // Copy a list of a CellList in neighbors
+    auto gatherCell = [&](std::pmr::vector<Point>& neighbors, const CellList& cells, int i) {
+        neighbors.reserve(cells.count(i));
+        for (int j = cells.begin(i); j < cells.end(i); ++j)
+            neighbors.emplace_back(cells.x[j], cells.y[j]);
+    };
+
+    const Scalar* centersX = nearCellulePointsList.x.data(); // Vertices of the Voronoi cells, indexed by cellTriangles
+    const Scalar* centersY = nearCellulePointsList.y.data();
+
+    const Domain<Scalar>& clipDomain = clippingDomain(); // Resolved once : building the disc domain lazily from the workers would be a race
+
+    // The raster cells cover the whole domain : one labelling of the grid gives the centroid of every cell
+    if (useRaster)
+        rasterVoronoi.compute(pointList, clipDomain, clippingGeneration, rasterResolution, threadPool);
+
+    // Only the centroid method reads the moments (and the clipped cells)
+    if (useCentroid && !useWelzl && !useSquare && !useRaster && !useAnisotropic)
+        ensureCellMoments();
+
+    if (useAnisotropic)
+        updateFieldFrames();
+
+    // With the clipped cells every point has a bounded cell, so the centroid method moves the border points too. The raster cells too
+    const bool         useClippedCells = useCentroid && !useWelzl && !useSquare && !useAnisotropic && clipCells && clippedCells.size() == pointList.size();
+    const bool         boundedCells    = useClippedCells || useRaster || (useAnisotropic && clipCells); // The anisotropic cells are clipped when they are built
+    const std::uint8_t skippedFlags    = boundedCells ? static_cast<std::uint8_t>(PointFlag::Pinned | PointFlag::Degenerate) : PointFlag::Fixed;
+
+    // What the method gives for one point : the center it moves to, and the circle or the box drawn for the Welzl and oriented box methods
+    struct CellTarget {
+        bool                 moves      = false;
+        bool                 degenerate = false; // Flagged Degenerate by the caller, the workers of the Jacobi sweep do not write the flags
+        Point                centroid;
+        bool                 hasCircle  = false;
+        Circle               circle;
+        bool                 hasBox     = false;
+        std::array<Point, 4> box;
+    };
+
+    // Target of the point i, computed from the positions in pointList. The temporaries are allocated in memory
+    auto cellTarget = [&](int i, std::pmr::memory_resource* memory, AnisotropicScratch& scratch) {
+        CellTarget              target;
+        std::pmr::vector<Point> neighbors(memory); // Get the neighbors of the current point
+
+        if (useRaster)
         {
-            // std::cerr << "Skipping centralisation for border point (" << pointList[i].first << ", " << pointList[i].second << ").\n";
-            continue; // Skip centralisation for border points
+            if (!rasterVoronoi.hasCentroid(i))
+                return target; // No pixel of the domain in the cell
+            target.centroid = rasterVoronoi.centroid(i);
         }
-
-        std::vector<Point> neighbors; // Get the neighbors of the current point
-        Point              centroid;
-
-        if (useWelzl)
+        else if (useWelzl)
         {
-            auto neighborsIdx = pointsAdjacentsIdx[i];
-            neighbors.clear();
-            for (const auto& idx : neighborsIdx)
+            gatherAdjacents(neighbors, i);
+            const Circle circle = smallEnclosingCircle<welzlBruteForceSize, Scalar>(neighbors, static_cast<std::uint32_t>(i)); // Smallest circle enclosing the neighbors
+            if (circle.second < 0)
             {
-                neighbors.push_back(pointList[idx]);
+                target.degenerate = true; // No neighbor : the point will not be moved anymore
+                return target;
             }
-            sortPointsCCW(neighbors);
-            std::vector<Point>      boundaryPoints;                            // Get the boundary points for the first point
-            std::pair<Point, float> circle = welzl(neighbors, boundaryPoints); // Calculate the circle using Welzl's algorithm
-            centroid                       = circle.first;                     // Calculate the centroid using Welzl's algorithm
-
-            if (pointEqual(centroid, Point{0, 0}))
-            {
-                std::cout << "Welzl returned (0, 0) for point (" << pointList[i].first << ", " << pointList[i].second
-                          << "). Removing this point of the list.\n";
-
-                // Check if the point is dupliacte in my list
-                int nbrApparition = 0;
-                for (const auto& p : pointList)
-                {
-                    if (pointEqual(p, pointList[i]))
-                    // std::cout << "Skipping centralisation for this duplicate point.\n";
-                    // std::cout << "--------------------------------------------------\n";
-                    {
-                        nbrApparition++;
-                    }
-                    if (nbrApparition > 1)
-                    {
-                        std::cerr << "Point (" << pointList[i].first << ", " << pointList[i].second
-                                  << ") appears multiple times in the point list. Skipping centralisation for this point.\n";
-                        break; // Skip centralisation for this point if it appears multiple times
-                    }
-                }
-
-                // Show neighbors
-                std::cout << "Neighbors for point (" << pointList[i].first << ", " << pointList[i].second << "):\n";
-                for (const auto& neighbor : neighbors)
-                {
-                    std::cout << "Neighbor: (" << neighbor.first << ", " << neighbor.second << ")\n";
-                }
-
-                // Remove the point from the list
-                idxPointBorder.push_back(i); // Add the index of the border point to the list
-                continue;                    // Skip centralisation for this point
-            }
-
-            allCircles.push_back(circle); // Store the circle for later use
+            target.centroid  = circle.first;
+            target.circle    = circle; // Stored for the drawing
+            target.hasCircle = true;
         }
         else if (useSquare)
         {
-            auto neighborsIdx = pointsAdjacentsIdx[i];
-            neighbors.clear();
-            for (const auto& idx : neighborsIdx)
-            {
-                neighbors.push_back(pointList[idx]);
-            }
-
-            centroid = squareCenter(neighbors);
+            gatherAdjacents(neighbors, i);
+            target.centroid = squareCenter<Scalar>(neighbors);
+        }
+        else if (useAnisotropic)
+        {
+            const CellMoments cell = computeAnisotropicCell(i, clipDomain, scratch);
+            if (!(cell.mass > 0))
+                return target; // Empty cell (the point is outside the domain)
+            target.centroid = cell.centroid;
         }
         else if (useCentroid)
         {
-            neighbors = nearCellulePoints[i]; // Get the neighbors from the nearCellulePoints
-            sortPointsCCW(neighbors);         // Sort neighbors in counter-clockwise order around the current point
-
-            centroid = computeCentroid(neighbors);
+            const CellMoments cell = getCellMoments(i); // Computed before the loop, weighted by the density
+            if (!(cell.mass > 0))
+                return target; // Empty clipped cell (the point is outside the domain) or not a polygon
+            target.centroid = cell.centroid;
         }
         else if (kNearest)
         {
-            neighbors = kNearestPoints[i]; // Get the k-nearest neighbors from the kNearestPoints
-            sortPointsCCW(neighbors);      // Sort neighbors in counter-clockwise order around the current point
+            gatherCell(neighbors, kNearestPoints, i); // Get the k-nearest neighbors from the kNearestPoints
+            sortPointsCCW<Real, Scalar>(neighbors);   // Sort neighbors in counter-clockwise order around the current point
 
-            centroid = computeCentroid(neighbors);
+            target.centroid = computeCentroid<Real, Scalar>(neighbors);
         }
         else if (useOrientedBox)
         {
-            auto neighborsIdx = pointsAdjacentsIdx[i];
-            neighbors.clear(); // Get the neighbors from the nearCellulePoints
-            for (const auto& idx : neighborsIdx)
+            std::pmr::vector<Point2<Real>> neighbors2D(memory);
+            neighbors2D.reserve(pointsAdjacentsIdx[i].size());
+            for (const int idx : pointsAdjacentsIdx[i])
+                neighbors2D.emplace_back(px[idx], py[idx]);
+
+            std::array<Point2<Real>, 4> orientedBox;
+            if (useMinimumAreaBox)
             {
-                neighbors.push_back(pointList[idx]);
+                std::pmr::vector<Point2<Real>> hull(neighbors2D.size(), memory); // Convex hull of the neighbors
+                orientedBox = computeMinimumAreaBox<Real>(neighbors2D, hull);
             }
-
-            // onvert neighbors to Point2D for oriented bounding box computation
-            std::vector<Point2D> neighbors2D;
-            neighbors2D.reserve(neighbors.size());
-            for (const auto& neighbor : neighbors)
+            else
             {
-                neighbors2D.emplace_back(neighbor.first, neighbor.second);
+                orientedBox = computeOrientedBoundingBox<Real>(neighbors2D);
             }
 
-            std::vector<Point2D> orientedBox = computeOrientedBoundingBox(neighbors2D);
-
-            std::vector<Point> orientedBoxPointsV = {
-                Point{orientedBox[0].x(), orientedBox[0].y()},
-                Point{orientedBox[1].x(), orientedBox[1].y()},
-                Point{orientedBox[2].x(), orientedBox[2].y()},
-                Point{orientedBox[3].x(), orientedBox[3].y()}
-            };
-
-            sortPointsCCW(orientedBoxPointsV);
-            centroid = computeCentroid(orientedBoxPointsV); // Calculate the centroid of the oriented bounding box
-
-            // Make the midpoint of the oriented bounding box the centroid
-            // centroid = {
-            //     (orientedBox[0].x() + orientedBox[1].x() + orientedBox[2].x() + orientedBox[3].x()) / 4.0f,
-            //     (orientedBox[0].y() + orientedBox[1].y() + orientedBox[2].y() + orientedBox[3].y()) / 4.0f
-            // };
-
-            // Store the oriented bounding box for later use
-            std::array<Point, 4> orientedBoxPoints = {
-                Point{orientedBox[0].x(), orientedBox[0].y()},
-                Point{orientedBox[1].x(), orientedBox[1].y()},
-                Point{orientedBox[2].x(), orientedBox[2].y()},
-                Point{orientedBox[3].x(), orientedBox[3].y()}
-            };
-            allOrientedBoxes.emplace_back(orientedBoxPoints); // Store the oriented bounding box for later use
+            // The center of the box is the mean of its corners
+            const Point2<Real> center = (orientedBox[0] + orientedBox[1] + orientedBox[2] + orientedBox[3]) / 4;
+            target.centroid           = Point(static_cast<Scalar>(center.x()), static_cast<Scalar>(center.y()));
+
+            // Store the oriented bounding box for the drawing
+            for (int corner = 0; corner < 4; ++corner)
+                target.box[corner] = Point(orientedBox[corner].x(), orientedBox[corner].y());
+            target.hasBox = true;
         }
         else if (useMean)
         {
-            neighbors = nearCellulePoints[i]; // Get the neighbors from the nearCellulePoints
-
-            centroid = computeCenter(neighbors);
+            // The triangles of the cell are contiguous in cellTriangles, so the mean is a reduction over the circumcenters they index
+            const int begin = cellTriangles.begin(i);
+            const int end   = cellTriangles.end(i);
+            Real      cx    = 0.0;
+            Real      cy    = 0.0;
+            for (int j = begin; j < end; ++j)
+            {
+                cx += centersX[cellTriangles.indices[j]];
+                cy += centersY[cellTriangles.indices[j]];
+            }
+            target.centroid = Point(cx / (end - begin), cy / (end - begin));
         }
         else
         {
-            std::cerr << "No valid method selected for centralisation. Skipping point (" << pointList[i].first << ", " << pointList[i].second << ").\n";
-            continue; // Skip if no valid method is selected
+            std::cerr << "No valid method selected for centralisation. Skipping point (" << px[i] << ", " << py[i] << ").\n";
+            return target; // Skip if no valid method is selected
+        }
+
+        target.moves = true;
+        return target;
+    };
+
+    // New position of the point i, a step from its position towards its target
+    auto stepTowards = [&](int i, const Point& centroid) {
+        return Point(static_cast<Scalar>((1 - step) * px[i] + step * centroid.first), static_cast<Scalar>((1 - step) * py[i] + step * centroid.second));
+    };
+
+    if (!jacobiSweep)
+    {
+        // Gauss-Seidel : each point moves at once, so the next points read its new position
+        AnisotropicScratch anisotropicScratch; // Buffers of the anisotropic cells, reused for every point
+        for (int i = 0; i < static_cast<int>(pointList.size()); ++i)
+        {
+            if (pointList.hasFlag(i, skippedFlags))
+                continue; // Skip centralisation for border, pinned and degenerate points
+
+            const CellTarget target = cellTarget(i, arena, anisotropicScratch);
+            if (target.degenerate)
+                pointList.setFlag(i, PointFlag::Degenerate);
+            if (target.hasCircle)
+                allCircles.push_back(target.circle);
+            if (target.hasBox)
+                allOrientedBoxes.push_back(target.box);
+            if (target.moves)
+                movePoint(i, stepTowards(i, target.centroid));
+        }
+        return;
+    }
+
+    // Jacobi : every target is computed from the positions of the previous iteration and written in the second buffer, which is swapped
+    // with the positions at the end. A point only reads pointList and writes its own slots, so the points run in parallel and the result
+    // does not depend on the number of threads
+    const int                    nbrPoints = static_cast<int>(pointList.size());
+    std::pmr::vector<CellTarget> targets(nbrPoints, arena);
+    jacobiX.assign(pointList.x.begin(), pointList.x.end());
+    jacobiY.assign(pointList.y.begin(), pointList.y.end());
+    threadPool.parallelFor(0, nbrPoints, [&](int pointBegin, int pointEnd) {
+        // The temporaries of a point fit in the stack buffer, rewound after each point
+        std::array<std::byte, 4096>         stackBuffer;
+        std::pmr::monotonic_buffer_resource memory(stackBuffer.data(), stackBuffer.size());
+        AnisotropicScratch                  scratch;
+        for (int i = pointBegin; i < pointEnd; ++i)
+        {
+            if (pointList.hasFlag(i, skippedFlags))
+                continue;
+            targets[i] = cellTarget(i, &memory, scratch);
+            memory.release();
+            if (targets[i].moves)
+            {
+                const Point moved = stepTowards(i, targets[i].centroid);
+                jacobiX[i]        = moved.first;
+                jacobiY[i]        = moved.second;
+            }
+        }
+    }, 64);
+
+    pointList.x.swap(jacobiX);
+    pointList.y.swap(jacobiY);
+    for (int i = 0; i < nbrPoints; ++i)
+    {
+        const CellTarget& target = targets[i];
+        if (target.degenerate)
+            pointList.setFlag(i, PointFlag::Degenerate);
+        if (target.hasCircle)
+            allCircles.push_back(target.circle);
+        if (target.hasBox)
+            allOrientedBoxes.push_back(target.box);
+        if (target.moves)
+        {
+            pointList.setFlag(i, PointFlag::Dirty);
+            if (spatialGrid.isBuiltFor(pointList))
+                spatialGrid.update(pointList, i);
         }
+    }
+}
+
+template<typename Precision>
+void BasicGraphe<Precision>::generateRandomPoints(int nbrRandomPoints, int nbrBorderPoints)
+{
+    pointList.clear();                                    // Clear the previous points
+    nearCellulePointsList.clear();                        // Clear the previous circumcenters
+    pointList.reserve(nbrRandomPoints + nbrBorderPoints); // Reserve space for new points
+    allCircles.clear();                                   // Clear the list of circles
+    energies.clear();                                     // Clear the list of energies
+    powerWeights.clear();                                 // The new points start from their Voronoi cells
+    cellTriangles.clear();                                // The rings of the previous points can not be reused
+    previousTriangles.clear();
+    spatialGrid.clear(); // Built for the previous points and bounds, the generation of pointList also changes even when the new set has the same size
+
+    std::default_random_engine eng(std::random_device{}());
+    if (domain)
+    {
+        // Uniform points in the loaded domain and border points along its outer ring
+        for (int i = 0; i < nbrRandomPoints; ++i)
+        {
+            const Point p = domain->randomPoint(eng);
+            pointList.emplace_back(p.first, p.second);
+        }
+        for (const Point& p : domain->borderPoints(nbrBorderPoints))
+            pointList.emplace_back(p.first, p.second, PointFlag::Border);
+        return;
+    }
+
+    std::uniform_real_distribution<double> rayon(0, radius - 5.);          // Random radius from 0 to the graph's radius - 1
+    std::uniform_real_distribution<double> angle(0, std::numbers::pi * 2); // 2 * pi
 
-        pointList[i] = {
-            (1 - step) * pointList[i].first + step * centroid.first,
-            (1 - step) * pointList[i].second + step * centroid.second
-        }; // Update the current point to the centroid
+    for (int i = 0; i < nbrRandomPoints; ++i)
+    {
+        pointList.emplace_back(
+            rayon(eng) * std::cos(angle(eng)), // Random x coordinate
+            rayon(eng) * std::sin(angle(eng))  // Random y coordinate
+        );                                     // Generate random points in a circle of radius 10
     }
-    // }
 
-    // std::cout << "Centralisation completed.\n";
+    // add border points to the graph
+    for (int i = 0; i < nbrBorderPoints; ++i)
+    {
+        float angle = static_cast<float>(i) * (2.f * std::numbers::pi / static_cast<float>(nbrBorderPoints)); // Calculate the angle for each point
+        pointList.emplace_back(
+            radius * std::cos(angle), // x coordinate
+            radius * std::sin(angle), // y coordinate
+            PointFlag::Border         // Generate points on the boundary of the circle
+        );
+    }
 }
 
-void Graphe::doDelaunayAndCalculateCenters()
+template<typename Precision>
+int BasicGraphe<Precision>::separateNearDuplicates()
 {
-    std::vector<dt::Vector2<double>> points;
+    refreshSpatialGrid();
+    separatedDuplicates.clear();
+
+    const Scalar          minDistance = static_cast<Scalar>(duplicateDistance);
+    const Domain<Scalar>& clipDomain  = clippingDomain(); // The separated points stay inside
+    std::vector<int>      close;                          // Points of the grid around the current point
+    std::vector<int>      around;                         // Points of the grid around a new position
+    for (int i = 0; i < static_cast<int>(pointList.size()); ++i)
+    {
+        spatialGrid.radius(pointList, pointList[i], minDistance, close);
+        for (const int j : close)
+        {
+            if (j <= i)
+                continue; // Each pair is handled once, from its first point
+
+            // Move the later point, unless it can not move (border, pinned)
+            int kept  = i;
+            int moved = j;
+            if (pointList.hasFlag(moved, PointFlag::Border | PointFlag::Pinned))
+                std::swap(kept, moved);
+            if (pointList.hasFlag(moved, PointFlag::Border | PointFlag::Pinned))
+                continue;
+
+            const Real dx = static_cast<Real>(pointList.x[moved]) - pointList.x[kept];
+            const Real dy = static_cast<Real>(pointList.y[moved]) - pointList.y[kept];
+            const Real d  = std::sqrt(dx * dx + dy * dy);
+            if (d >= minDistance)
+                continue;
+
+            // Push the moved point at twice minDistance of the kept one (so that rounding does not make it a duplicate again at the next pass),
+            // along their direction or along a direction given by its index if they are equal. A position outside of the domain or close to
+            // another point is tried again with the direction turned by the golden angle. The last attempts only check the other points, for
+            // a kept point lying outside of the domain
+            const Real separation = 2 * static_cast<Real>(minDistance);
+            Real       angle      = d > 0 ? std::atan2(dy, dx) : static_cast<Real>(moved * goldenAngle);
+            bool       separated  = false;
+            for (int attempt = 0; attempt < 2 * maxSeparationAttempts && !separated; ++attempt, angle += static_cast<Real>(goldenAngle))
+            {
+                const Point candidate(static_cast<Scalar>(pointList.x[kept] + std::cos(angle) * separation),
+                                      static_cast<Scalar>(pointList.y[kept] + std::sin(angle) * separation));
+                if (attempt < maxSeparationAttempts && !clipDomain.contains(candidate))
+                    continue;
+                spatialGrid.radius(pointList, candidate, minDistance, around);
+                if (std::any_of(around.begin(), around.end(), [&](int idx) { return idx != moved; }))
+                    continue;
+
+                movePoint(moved, candidate);
+                pointList.clearFlag(moved, PointFlag::Degenerate); // Its cell can be computed again
+                separatedDuplicates.emplace_back(kept, moved);
+                separated = true;
+            }
+            if (!separated)
+                pointList.setFlag(moved, PointFlag::Degenerate); // No free place around : left in place, and not moved by the centralisation
+        }
+    }
+
+    // Reported by the GUI through the snapshot (nbrSeparatedDuplicates)
+    return static_cast<int>(separatedDuplicates.size());
+}
+
+template<typename Precision>
+void BasicGraphe<Precision>::doDelaunayAndCalculateCenters()
+{
+    separateNearDuplicates(); // Duplicate points would give degenerate triangles, also indexes the points for the border detection and the GUI queries
+
+    triangulateAndBuildCells();
+    if (capacityConstrained)
+        solveCapacityWeights(); // Power cells of equal mass around the current points
+}
+
+template<typename Precision>
+void BasicGraphe<Precision>::triangulateAndBuildCells()
+{
+    // The triangulation runs in Real precision : its predicates are evaluated in the same type as the accumulators of the graph
+    std::vector<dt::Vector2<Real>> points;
     points.reserve(pointList.size());
-    for (const auto& point : pointList)
+    for (int i = 0; i < static_cast<int>(pointList.size()); ++i)
     {
-        points.emplace_back(point.first, point.second); // Convert Point to dt::Vector2
+        points.emplace_back(pointList.x[i], pointList.y[i]); // Convert Point to dt::Vector2
     }
 
-    dt::Delaunay<double>                    triangulation;
-    const auto                              start = std::chrono::high_resolution_clock::now();
-    const std::vector<dt::Triangle<double>> triangles =
-        triangulation.triangulate(points);
+    dt::Delaunay<Real>                    triangulation;
+    const auto                            start = std::chrono::high_resolution_clock::now();
+    const std::vector<dt::Triangle<Real>>& triangles =
+        hasPowerWeights() ? triangulation.triangulate(points, powerWeights) : triangulation.triangulate(points);
     const auto                          end  = std::chrono::high_resolution_clock::now();
     const std::chrono::duration<double> diff = end - start;
 
-    set_triangles(triangles); // Set the triangles in the graph
+    triangulationMemory.bytes       = 0;
+    triangulationMemory.allocations = 0;
+    triangulationMemory.add(points).add(triangulation.getTriangles()).add(triangulation.getEdges()).add(triangulation.getVertices());
+
+    previousTriangles.swap(idxTriangles);    // Matched with the new triangles to reuse the rings which did not change
+    set_triangles(triangles, points.data()); // Set the triangles in the graph
+    pointList.clearFlag(PointFlag::Dirty);   // Every point is up to date with the triangulation
 
-    nearCellulePoints.clear();                  // Clear the nearCellulePoints vector to prepare for new data
-    nearCellulePointsList.clear();              // Clear the nearCellulePointsList vector to prepare for new data
-    celluleBorder.clear();                      // Clear the celluleBorder vector to prepare for new data
-    nearCellulePoints.resize(pointList.size()); // Resize the nearCellulePoints vector to match the number of points in the graph
-    kNearestPoints.clear();                     // Clear the kNearestPoints vector to prepare for new data
+    nearCellulePointsList.clear(); // Clear the nearCellulePointsList vector to prepare for new data
+    celluleBorder.clear();         // Clear the celluleBorder vector to prepare for new data
+    kNearestPoints.clear();        // Clear the kNearestPoints vector to prepare for new data
 
-    calculateCenterFromDelaunayTriangles(idxTriangles); // Calculate the centers of the circumcircles of the triangles and store them in nearCellulePoints
+    calculateCenterFromDelaunayTriangles(idxTriangles); // Calculate the centers of the circumcircles of the triangles and store them in nearCellulePointsList
+    cellsGeneration++; // The clipped cells and the moments are built again by the first consumer which needs them
 
     // Determine if an original point is a border point
 
     // idxPointBorder.clear(); // Clear the idxPointBorder vector to prepare for new data
     // if (!hasDetectedBorder)
     findBorderPoints(); // Find the border points in the graph
-
-    triesNearCellulePoints();
 }
 
-int Graphe::flipDelaunayTriangles()
+template<typename Precision>
+int BasicGraphe<Precision>::flipDelaunayTriangles()
 {
     const auto start = std::chrono::high_resolution_clock::now();
 
@@ -328,7 +537,7 @@ int Graphe::flipDelaunayTriangles()
 
     nbrFlips = 0; // Reset the number of flips performed during the Delaunay triangulation
 
-    for (int i = 0; i < idxTriangles.size(); ++i)
+    for (int i = 0; i < static_cast<int>(idxTriangles.size()); ++i)
     {
         auto start2 = std::chrono::high_resolution_clock::now();
 
@@ -405,7 +614,7 @@ int Graphe::flipDelaunayTriangles()
             {
                 if (distance(pointList[neighborIdx], circle.first) < circle.second) // Check if the neighbor is inside the circumcircle
                 {
-                    for (int j = 0; j < idxTriangles.size(); ++j)
+                    for (int j = 0; j < static_cast<int>(idxTriangles.size()); ++j)
                     {
                         if (std::find(idxTriangles[j].begin(), idxTriangles[j].end(), neighborIdx) != idxTriangles[j].end()
                             && std::find(idxTriangles[j].begin(), idxTriangles[j].end(), idxA) != idxTriangles[j].end()
@@ -414,29 +623,10 @@ int Graphe::flipDelaunayTriangles()
                             idxTriangles[i] = {idxC, neighborIdx, idxA}; // Swap the neighbor with point A in the current triangle
                             idxTriangles[j] = {idxC, neighborIdx, idxB}; // Swap the neighbor with point B in the adjacent triangle
 
-                            auto computeCircumcircle = [&](const std::array<int, 3>& triangle) -> Circle {
-                                Point p1 = pointList[triangle[0]];
-                                Point p2 = pointList[triangle[1]];
-                                Point p3 = pointList[triangle[2]];
-
-                                std::array<std::array<float, 3>, 3> matForX{{{1.f, p1.second, static_cast<float>((std::pow(p1.second, 2) + std::pow(p1.first, 2)) / 2.)}, {1.f, p2.second, static_cast<float>((std::pow(p2.second, 2) + std::pow(p2.first, 2)) / 2.)}, {1.f, p3.second, static_cast<float>((std::pow(p3.second, 2) + std::pow(p3.first, 2)) / 2.)}}};
-                                auto                                x = static_cast<float>(-determinant3x3(matForX));
-
-                                std::array<std::array<float, 3>, 3> matForY{{{1.f, static_cast<float>(p1.first), static_cast<float>((std::pow(p1.second, 2) + std::pow(p1.first, 2)) / 2.)}, {1.f, static_cast<float>(p2.first), static_cast<float>((std::pow(p2.second, 2) + std::pow(p2.first, 2)) / 2.)}, {1.f, static_cast<float>(p3.first), static_cast<float>((std::pow(p3.second, 2) + std::pow(p3.first, 2)) / 2.)}}};
-                                auto                                y = static_cast<float>(determinant3x3(matForY));
-
-                                std::array<std::array<float, 3>, 3> matForW{{{1.f, static_cast<float>(p1.first), static_cast<float>(p1.second)}, {1.f, static_cast<float>(p2.first), static_cast<float>(p2.second)}, {1.f, static_cast<float>(p3.first), static_cast<float>(p3.second)}}};
-                                auto                                w = static_cast<float>(determinant3x3(matForW));
-
-                                Point center(x / w, y / w);
-                                float radius = std::sqrt(std::pow(p1.first - center.first, 2) + std::pow(p1.second - center.second, 2));
-                                return Circle(center, radius);
-                            };
-
-                            std::array<int, 3> triangleI = idxTriangles[i];
-                            std::array<int, 3> triangleJ = idxTriangles[j];
-                            triangleCircles[i]           = computeCircumcircle(triangleI);
-                            triangleCircles[j]           = computeCircumcircle(triangleJ); // Recompute the circumcircle for the new triangles
+                            const std::array<int, 3>& triangleI = idxTriangles[i];
+                            const std::array<int, 3>& triangleJ = idxTriangles[j];
+                            triangleCircles[i]                  = computeCircumcircle(triangleI[0], triangleI[1], triangleI[2]);
+                            triangleCircles[j]                  = computeCircumcircle(triangleJ[0], triangleJ[1], triangleJ[2]); // Recompute the circumcircle for the new triangles
 
                             nbrFlips++; // Increment the number of flips performed
                         }
@@ -466,29 +656,39 @@ int Graphe::flipDelaunayTriangles()
     return nbrFlips; // Return the number of flips performed during the Delaunay triangulation
 }
 
-void Graphe::doDelaunayFlipVersion(int& nbrFlips)
+template<typename Precision>
+void BasicGraphe<Precision>::doDelaunayFlipVersion(int& nbrFlips)
 {
-    nbrFlips = flipDelaunayTriangles(); // Perform Delaunay triangulation and flip triangles
+    separateNearDuplicates(); // Duplicate points would give degenerate triangles, also indexes the points for the border detection and the GUI queries
+    powerWeights.clear();     // The flips only restore the Delaunay criterion, the cells are the Voronoi cells
 
-    set_triangle_v2(); // Set the triangles in the graph
+    previousTriangles = idxTriangles;            // The flips change the triangles in place, the others keep their index and their rings
+    nbrFlips          = flipDelaunayTriangles(); // Perform Delaunay triangulation and flip triangles
+
+    if (nbrFlips == 0 && pointsAdjacentsIdx.size() == pointList.size())
+        updateTriangleCircles(); // Same triangles : the adjacency is unchanged, only the circumcenters moved with the points
+    else
+        set_triangle_v2(); // Set the triangles in the graph
+    pointList.clearFlag(PointFlag::Dirty); // Every point is up to date with the triangulation
 
     // Calculate the circumcenter of each triangle and add this center for Voronoil cellule points
 
     // std::cout << "Calcul for Voronoil : " << "\n";
 
-    nearCellulePoints.clear();                  // Clear the nearCellulePoints vector to prepare for new data
-    nearCellulePointsList.clear();              // Clear the nearCellulePointsList vector to prepare for new data
-    celluleBorder.clear();                      // Clear the celluleBorder vector to prepare for new data
-    nearCellulePoints.resize(pointList.size()); // Resize the nearCellulePoints vector to match the number of points in the graph
-    kNearestPoints.clear();                     // Clear the kNearestPoints vector to prepare for new data
+    nearCellulePointsList.clear(); // Clear the nearCellulePointsList vector to prepare for new data
+    celluleBorder.clear();         // Clear the celluleBorder vector to prepare for new data
+    kNearestPoints.clear();        // Clear the kNearestPoints vector to prepare for new data
 
-    calculateCenterFromDelaunayTriangles(idxTriangles); // Calculate the centers of the circumcircles of the triangles and store them in nearCellulePoints
+    calculateCenterFromDelaunayTriangles(idxTriangles); // Calculate the centers of the circumcircles of the triangles and store them in nearCellulePointsList
+    cellsGeneration++; // The clipped cells and the moments are built again by the first consumer which needs them
 
     // Determine if an original point is a border point
 
     // idxPointBorder.clear(); // Clear the idxPointBorder vector to prepare for new data
     // if (!hasDetectedBorder)
     findBorderPoints(); // Find the border points in the graph
+}
 
-    triesNearCellulePoints();
-}
\ No newline at end of file
+template struct BasicGraphe<FloatPrecision>;
+template struct BasicGraphe<DoublePrecision>;
+template struct BasicGraphe<MixedPrecision>;
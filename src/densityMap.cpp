@@ -0,0 +1,330 @@
+#include "densityMap.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+// Density of the white pixels, so the cells in the light areas keep a mass and a centroid
+constexpr double minimumDensity = 0.01;
+
+// Integrals of (i + s)^k (alpha + beta s) for s in [s0, s1], for k = 0, 1 and 2 in g
+static void cellIntegrals(double alpha, double beta, int i, double s0, double s1, double g[3])
+{
+    // Integral of s^k (alpha + beta s) from 0 to s
+    auto primitive0 = [&](double s) { return alpha * s + beta * s * s / 2; };
+    auto primitive1 = [&](double s) { return alpha * s * s / 2 + beta * s * s * s / 3; };
+    auto primitive2 = [&](double s) { return alpha * s * s * s / 3 + beta * s * s * s * s / 4; };
+
+    const double i0 = primitive0(s1) - primitive0(s0);
+    const double i1 = primitive1(s1) - primitive1(s0);
+    const double i2 = primitive2(s1) - primitive2(s0);
+    g[0]            = i0;
+    g[1]            = i * i0 + i1;
+    g[2]            = static_cast<double>(i) * i * i0 + 2. * i * i1 + i2;
+}
+
+// Next token of a PGM header, skipping the comments
+static bool readHeaderValue(std::istream& in, int& value)
+{
+    for (;;)
+    {
+        in >> std::ws;
+        if (in.peek() != '#')
+            break;
+        std::string comment;
+        std::getline(in, comment);
+    }
+    return static_cast<bool>(in >> value);
+}
+
+template<typename T>
+bool DensityMap<T>::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not open the density image: " << path << '\n';
+        return false;
+    }
+
+    std::string magic;
+    file >> magic;
+    if (magic != "P2" && magic != "P5")
+    {
+        std::cerr << "The density image is not a PGM file (P2 or P5): " << path << '\n';
+        return false;
+    }
+
+    int width  = 0;
+    int height = 0;
+    int maxVal = 0;
+    if (!readHeaderValue(file, width) || !readHeaderValue(file, height) || !readHeaderValue(file, maxVal) || width < 2 || height < 2 || maxVal <= 0
+        || maxVal > 65535)
+    {
+        std::cerr << "Invalid header in the density image: " << path << '\n';
+        return false;
+    }
+
+    std::vector<double> pixels(static_cast<std::size_t>(width) * height);
+    if (magic == "P5")
+        file.get(); // Single whitespace before the binary data
+    for (int row = 0; row < height; ++row)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            int gray = 0;
+            if (magic == "P2")
+            {
+                file >> gray;
+            }
+            else if (maxVal < 256)
+            {
+                gray = file.get();
+            }
+            else
+            {
+                const int high = file.get();
+                gray           = high * 256 + file.get();
+            }
+            if (!file)
+            {
+                std::cerr << "The density image is truncated: " << path << '\n';
+                return false;
+            }
+
+            // The rows of the file go down, the rows of the map go up
+            const double dark                                          = 1. - std::clamp(gray, 0, maxVal) / static_cast<double>(maxVal);
+            pixels[static_cast<std::size_t>(height - 1 - row) * width + x] = minimumDensity + (1. - minimumDensity) * dark;
+        }
+    }
+
+    m_width  = width;
+    m_height = height;
+    m_pixels = std::move(pixels);
+    buildTables();
+    return true;
+}
+
+template<typename T>
+void DensityMap<T>::setBilinear(bool bilinear)
+{
+    if (bilinear == m_bilinear)
+        return;
+    m_bilinear = bilinear;
+    buildTables();
+}
+
+template<typename T>
+void DensityMap<T>::setFrame(T minX, T minY, T maxX, T maxY)
+{
+    m_frame[0] = minX;
+    m_frame[1] = minY;
+    m_frame[2] = maxX;
+    m_frame[3] = maxY;
+    if (empty())
+        return;
+
+    const double pixelX = (static_cast<double>(maxX) - minX) / m_width;
+    const double pixelY = (static_cast<double>(maxY) - minY) / m_height;
+    m_scaleX            = pixelX;
+    m_scaleY            = pixelY;
+    m_originX           = m_bilinear ? minX - pixelX / 2 : minX; // The bilinear grid joins the pixel centers, from the half outside cells
+    m_originY           = m_bilinear ? minY - pixelY / 2 : minY;
+}
+
+template<typename T>
+void DensityMap<T>::buildTables()
+{
+    if (empty())
+        return;
+
+    // Clamped to the image : the corners of the outer cells of the bilinear grid repeat the edge pixels
+    auto pixel = [&](int x, int y) {
+        return m_pixels[static_cast<std::size_t>(std::clamp(y, 0, m_height - 1)) * m_width + std::clamp(x, 0, m_width - 1)];
+    };
+
+    m_nx   = m_bilinear ? m_width + 1 : m_width;
+    m_ny   = m_bilinear ? m_height + 1 : m_height;
+    m_edge = m_bilinear ? 0.5 : 0.;
+    m_coefficients.resize(4 * static_cast<std::size_t>(m_nx) * m_ny);
+    for (int j = 0; j < m_ny; ++j)
+    {
+        for (int i = 0; i < m_nx; ++i)
+        {
+            double* c = &m_coefficients[4 * (static_cast<std::size_t>(j) * m_nx + i)];
+            if (m_bilinear)
+            {
+                const double p00 = pixel(i - 1, j - 1);
+                const double p10 = pixel(i, j - 1);
+                const double p01 = pixel(i - 1, j);
+                const double p11 = pixel(i, j);
+                c[0]             = p00;
+                c[1]             = p10 - p00;
+                c[2]             = p01 - p00;
+                c[3]             = p11 - p10 - p01 + p00;
+            }
+            else
+            {
+                c[0] = pixel(i, j);
+                c[1] = 0;
+                c[2] = 0;
+                c[3] = 0;
+            }
+        }
+    }
+
+    // Integral of (i + s)^k (alpha + beta s) over the part of each cell inside the frame, added column after column. It is linear in
+    // (alpha, beta), so the constant and the t coefficients of rho give the constant and the t coefficients of the prefix
+    m_prefix.assign(6 * static_cast<std::size_t>(m_nx + 1) * m_ny, 0.);
+    for (int j = 0; j < m_ny; ++j)
+    {
+        for (int i = 0; i < m_nx; ++i)
+        {
+            const double* c    = &m_coefficients[4 * (static_cast<std::size_t>(j) * m_nx + i)];
+            const double* from = &m_prefix[6 * (static_cast<std::size_t>(j) * (m_nx + 1) + i)];
+            double*       to   = &m_prefix[6 * (static_cast<std::size_t>(j) * (m_nx + 1) + i + 1)];
+            for (int part = 0; part < 2; ++part)
+            {
+                double g[3];
+                cellIntegrals(c[part * 2], c[part * 2 + 1], i, cellStart(i), cellEnd(i), g); // a and b, then c and d
+                to[part]     = from[part] + g[0];
+                to[2 + part] = from[2 + part] + g[1];
+                to[4 + part] = from[4 + part] + g[2];
+            }
+        }
+    }
+
+    setFrame(m_frame[0], m_frame[1], m_frame[2], m_frame[3]);
+}
+
+template<typename T>
+double DensityMap<T>::value(double x, double y) const
+{
+    if (empty())
+        return 0;
+
+    const double u = (x - m_originX) / m_scaleX;
+    const double v = (y - m_originY) / m_scaleY;
+    if (!(u >= m_edge && u <= m_nx - m_edge && v >= m_edge && v <= m_ny - m_edge))
+        return 0;
+
+    const int     i = std::min(static_cast<int>(u), m_nx - 1); // The border of the frame belongs to the last cell
+    const int     j = std::min(static_cast<int>(v), m_ny - 1);
+    const double  s = u - i;
+    const double  t = v - j;
+    const double* c = &m_coefficients[4 * (static_cast<std::size_t>(j) * m_nx + i)];
+    return c[0] + c[1] * s + c[2] * t + c[3] * s * t;
+}
+
+template<typename T>
+void DensityMap<T>::addSegment(double x1, double y1, double x2, double y2, Moments& moments) const
+{
+    if (empty())
+        return;
+
+    // In the coordinates of the grid
+    const double u1 = (x1 - m_originX) / m_scaleX;
+    const double v1 = (y1 - m_originY) / m_scaleY;
+    const double u2 = (x2 - m_originX) / m_scaleX;
+    const double v2 = (y2 - m_originY) / m_scaleY;
+    const double du = u2 - u1;
+    const double dv = v2 - v1;
+    if (dv == 0)
+        return; // The integrals are along dy
+
+    // The pieces of the segment in each cell of the grid : between the crossings of the grid lines and of the border of the frame, merged in
+    // increasing order. Outside of the rows of the frame the density is zero, on its left too
+    auto crossingAfter = [](double from, double delta, double tau, double lowest, double highest) {
+        if (delta == 0)
+            return 2.;
+        const double position = from + tau * delta;
+        const double step     = delta > 0 ? 1. : -1.;
+        const double line     = delta > 0 ? std::floor(position) + 1 : std::ceil(position) - 1;
+        double       first    = 2.; // Parameter of the first crossing after tau
+
+        auto consider = [&](double crossed) {
+            const double next = (crossed - from) / delta;
+            if (next > tau && next < first)
+                first = next;
+        };
+        for (const double candidate : {line, line + step}) // The next line, and the one after if the rounding put the position just past it
+        {
+            if (candidate >= lowest && candidate <= highest)
+                consider(candidate);
+        }
+        consider(lowest); // The border of the frame, which is not on a grid line for the bilinear grid
+        consider(highest);
+        return first;
+    };
+
+    // Gauss-Legendre with 3 points, exact for the polynomials of degree 5 met here
+    constexpr double nodes[3]   = {0.5 - 0.3872983346207417, 0.5, 0.5 + 0.3872983346207417};
+    constexpr double weights[3] = {5. / 18., 8. / 18., 5. / 18.};
+
+    double tau = 0.;
+    while (tau < 1.)
+    {
+        const double nextU = crossingAfter(u1, du, tau, m_edge, m_nx - m_edge);
+        const double nextV = crossingAfter(v1, dv, tau, m_edge, m_ny - m_edge);
+        double       next  = std::min({nextU, nextV, 1.});
+        if (!(next > tau))
+            next = 1.; // Rounding at a grid line
+
+        const double middleU = u1 + (tau + next) / 2 * du;
+        const double middleV = v1 + (tau + next) / 2 * dv;
+        const int    j       = static_cast<int>(std::floor(middleV));
+        if (middleV > m_edge && middleV < m_ny - m_edge && middleU > m_edge)
+        {
+            const int     i      = std::min(static_cast<int>(std::floor(middleU)), m_nx); // Right of the grid : the whole row
+            const double* prefix = &m_prefix[6 * (static_cast<std::size_t>(j) * (m_nx + 1) + i)];
+            const double* c      = i < m_nx ? &m_coefficients[4 * (static_cast<std::size_t>(j) * m_nx + i)] : nullptr;
+            const double  pieceV = (next - tau) * dv;
+
+            for (int q = 0; q < 3; ++q)
+            {
+                const double point = tau + nodes[q] * (next - tau);
+                const double u     = u1 + point * du;
+                const double v     = v1 + point * dv;
+                const double t     = v - j;
+
+                double g0 = prefix[0] + prefix[1] * t;
+                double g1 = prefix[2] + prefix[3] * t;
+                double g2 = prefix[4] + prefix[5] * t;
+                if (c)
+                {
+                    // Integral of (i + s)^k rho from the left of the cell (or the border of the frame) to u
+                    double g[3];
+                    cellIntegrals(c[0] + c[2] * t, c[1] + c[3] * t, i, cellStart(i), std::clamp(u - i, cellStart(i), cellEnd(i)), g);
+                    g0 += g[0];
+                    g1 += g[1];
+                    g2 += g[2];
+                }
+
+                const double w = weights[q] * pieceV;
+                moments.mass += w * g0;
+                moments.x += w * g1;
+                moments.xx += w * g2;
+                moments.y += w * v * g0;
+                moments.yy += w * v * v * g0;
+            }
+        }
+        tau = next;
+    }
+}
+
+template<typename T>
+typename DensityMap<T>::Moments DensityMap<T>::toWorld(const Moments& grid) const
+{
+    // x = originX + scaleX u and y = originY + scaleY v, the area element being scaleX scaleY du dv
+    const double jacobian = m_scaleX * m_scaleY;
+    Moments      world;
+    world.mass = jacobian * grid.mass;
+    world.x    = jacobian * (m_originX * grid.mass + m_scaleX * grid.x);
+    world.y    = jacobian * (m_originY * grid.mass + m_scaleY * grid.y);
+    world.xx   = jacobian * (m_originX * m_originX * grid.mass + 2 * m_originX * m_scaleX * grid.x + m_scaleX * m_scaleX * grid.xx);
+    world.yy   = jacobian * (m_originY * m_originY * grid.mass + 2 * m_originY * m_scaleY * grid.y + m_scaleY * m_scaleY * grid.yy);
+    return world;
+}
+
+template class DensityMap<float>;
+template class DensityMap<double>;
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "memoryReport.hpp"
+
+// Density of the points read from a grayscale image stretched over a rectangle of the plane, dark pixels being dense. The density is either
+// constant on each pixel or bilinear between the pixel centers, and the integrals over a region are exact for both.
+// They come from Green's theorem : the integral of x^k rho over a region is the integral of G_k dy along its border, where G_k(x, y) is the
+// integral of s^k rho(s, y) from the left of the image to x. G_k is read from per-row prefix tables at the column boundaries plus a polynomial
+// in the current column, so a border segment costs one polynomial quadrature per grid cell it crosses, whatever the area of the region
+template<typename T>
+class DensityMap {
+public:
+    // Integrals of rho, rho x, rho y, rho x^2 and rho y^2 over a region
+    struct Moments {
+        double mass = 0;
+        double x    = 0;
+        double y    = 0;
+        double xx   = 0;
+        double yy   = 0;
+    };
+
+    // Read a PGM image (P2 or P5). Returns false (and leaves the map unchanged) on error
+    bool load(const std::string& path);
+
+    bool empty() const { return m_pixels.empty(); }
+    int  width() const { return m_width; }
+    int  height() const { return m_height; }
+
+    bool bilinear() const { return m_bilinear; }
+    void setBilinear(bool bilinear);
+
+    // Rectangle of the plane covered by the image
+    void setFrame(T minX, T minY, T maxX, T maxY);
+
+    // Density at a point of the plane, zero outside of the frame
+    double value(double x, double y) const;
+
+    // Add the integrals along the oriented segment (x1, y1) -> (x2, y2) of the border of a region (the region on its left) to moments, in
+    // the coordinates of the grid : once every segment is added, toWorld() gives the moments of the region
+    void    addSegment(double x1, double y1, double x2, double y2, Moments& moments) const;
+    Moments toWorld(const Moments& grid) const;
+
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage{"densityMap"};
+        usage.add(m_pixels).add(m_coefficients).add(m_prefix);
+        return usage;
+    }
+
+private:
+    void buildTables();
+
+    // Part of the column i inside the frame, in the coordinate s of its cells
+    double cellStart(int i) const { return std::max(0., m_edge - i); }
+    double cellEnd(int i) const { return std::min(1., m_nx - m_edge - i); }
+
+    int                 m_width    = 0;
+    int                 m_height   = 0;
+    std::vector<double> m_pixels;          // Density of each pixel, the first row at the bottom
+    bool                m_bilinear = false;
+
+    // Grid of the interpolation : the pixels, or the squares between the pixel centers for the bilinear density. The bilinear grid has one
+    // more cell on each side, half inside the frame, where the edge pixels are extended up to the border of the frame
+    int                 m_nx   = 0;
+    int                 m_ny   = 0;
+    double              m_edge = 0; // The frame is [m_edge, m_nx - m_edge] x [m_edge, m_ny - m_edge] in the coordinates of the grid
+    std::vector<double> m_coefficients; // rho = a + b s + c t + d s t in each cell, for (s, t) in [0, 1]^2
+    std::vector<double> m_prefix;       // For each row and each column boundary, G_0, G_1 and G_2 at the boundary as A + B t
+
+    double m_originX = 0; // Position of the corner (0, 0) of the grid
+    double m_originY = 0;
+    double m_scaleX  = 1; // Size of a cell of the grid
+    double m_scaleY  = 1;
+
+    T m_frame[4] = {0, 0, 1, 1}; // minX, minY, maxX, maxY
+};
@@ -0,0 +1,364 @@
+#include "domain.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numbers>
+#include <sstream>
+
+// Twice the signed area of the ring, positive if it is counter-clockwise
+template<typename T>
+static double signedArea2(const std::vector<std::pair<T, T>>& ring)
+{
+    double area = 0;
+    for (std::size_t i = 0; i < ring.size(); ++i)
+    {
+        const auto& p0 = ring[i];
+        const auto& p1 = ring[(i + 1) % ring.size()];
+        area += static_cast<double>(p0.first) * p1.second - static_cast<double>(p1.first) * p0.second;
+    }
+    return area;
+}
+
+// Sign of the orientation of (a, b, c) : positive if c is on the left of a -> b
+template<typename T>
+static double orientation(const std::pair<T, T>& a, const std::pair<T, T>& b, const std::pair<T, T>& c)
+{
+    return (static_cast<double>(b.first) - a.first) * (static_cast<double>(c.second) - a.second)
+         - (static_cast<double>(b.second) - a.second) * (static_cast<double>(c.first) - a.first);
+}
+
+template<typename T>
+Domain<T> Domain<T>::disc(T radius, int nbrSegments)
+{
+    Ring ring;
+    ring.reserve(nbrSegments);
+    for (int i = 0; i < nbrSegments; ++i)
+    {
+        const double angle = 2 * std::numbers::pi * i / nbrSegments;
+        ring.emplace_back(static_cast<T>(radius * std::cos(angle)), static_cast<T>(radius * std::sin(angle)));
+    }
+
+    Domain domain;
+    domain.setRings({std::move(ring)});
+    return domain;
+}
+
+template<typename T>
+bool Domain<T>::load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not open the domain file: " << path << '\n';
+        return false;
+    }
+
+    std::vector<Ring> rings(1);
+    std::string       line;
+    int               lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+        if (!line.empty() && line[0] == '#')
+            continue;
+
+        std::istringstream iss(line);
+        Point              p;
+        if (!(iss >> p.first))
+        {
+            if (!rings.back().empty())
+                rings.emplace_back(); // An empty line closes the current ring
+            continue;
+        }
+        if (!(iss >> p.second))
+        {
+            std::cerr << "Invalid vertex at line " << lineNumber << " of the domain file: " << path << '\n';
+            return false;
+        }
+        rings.back().push_back(p);
+    }
+    if (rings.back().empty())
+        rings.pop_back();
+
+    if (rings.empty())
+    {
+        std::cerr << "The domain file has no ring: " << path << '\n';
+        return false;
+    }
+    for (const auto& ring : rings)
+    {
+        if (ring.size() < 3)
+        {
+            std::cerr << "A ring of the domain file has less than 3 vertices: " << path << '\n';
+            return false;
+        }
+    }
+
+    setRings(std::move(rings));
+    return true;
+}
+
+template<typename T>
+void Domain<T>::setRings(std::vector<Ring> rings)
+{
+    m_rings = std::move(rings);
+    m_edges.clear();
+    m_area = 0;
+
+    for (std::size_t r = 0; r < m_rings.size(); ++r)
+    {
+        Ring&        ring = m_rings[r];
+        const double area = signedArea2(ring);
+        if ((r == 0) != (area > 0))
+            std::reverse(ring.begin(), ring.end()); // The outer ring counter-clockwise, the holes clockwise
+        m_area += static_cast<T>(r == 0 ? std::abs(area) / 2 : -std::abs(area) / 2);
+
+        for (std::size_t i = 0; i < ring.size(); ++i)
+            m_edges.push_back(Edge{ring[i], ring[(i + 1) % ring.size()]});
+    }
+
+    buildGrid();
+}
+
+template<typename T>
+int Domain<T>::cellX(T x) const
+{
+    return std::clamp(static_cast<int>(std::floor((x - m_minX) / m_cellSize)), 0, m_nx - 1);
+}
+
+template<typename T>
+int Domain<T>::cellY(T y) const
+{
+    return std::clamp(static_cast<int>(std::floor((y - m_minY) / m_cellSize)), 0, m_ny - 1);
+}
+
+template<typename T>
+void Domain<T>::buildGrid()
+{
+    m_cells.clear();
+    m_centerInside.clear();
+    m_nx = 0;
+    m_ny = 0;
+    if (m_edges.empty())
+        return;
+
+    m_minX = m_maxX = m_edges[0].a.first;
+    m_minY = m_maxY = m_edges[0].a.second;
+    for (const Edge& edge : m_edges)
+    {
+        m_minX = std::min(m_minX, edge.a.first);
+        m_maxX = std::max(m_maxX, edge.a.first);
+        m_minY = std::min(m_minY, edge.a.second);
+        m_maxY = std::max(m_maxY, edge.a.second);
+    }
+
+    // About one edge per cell
+    const T width  = m_maxX - m_minX;
+    const T height = m_maxY - m_minY;
+    m_cellSize     = std::sqrt(width * height / static_cast<T>(m_edges.size()));
+    if (!(m_cellSize > 0))
+        m_cellSize = std::max(width, height);
+    if (!(m_cellSize > 0))
+        m_cellSize = 1;
+    m_nx = std::max(1, static_cast<int>(std::ceil(width / m_cellSize)));
+    m_ny = std::max(1, static_cast<int>(std::ceil(height / m_cellSize)));
+    m_cells.resize(static_cast<std::size_t>(m_nx) * m_ny);
+
+    // Every cell crossed by an edge : for each row the edge spans, the columns between its abscissas at the bottom and at the top of the row
+    for (int e = 0; e < static_cast<int>(m_edges.size()); ++e)
+    {
+        const Point& a = m_edges[e].a;
+        const Point& b = m_edges[e].b;
+        for (int y = cellY(std::min(a.second, b.second)); y <= cellY(std::max(a.second, b.second)); ++y)
+        {
+            T x0 = std::min(a.first, b.first);
+            T x1 = std::max(a.first, b.first);
+            if (a.second != b.second)
+            {
+                const T bottom  = std::max(std::min(a.second, b.second), m_minY + y * m_cellSize);
+                const T top     = std::min(std::max(a.second, b.second), m_minY + (y + 1) * m_cellSize);
+                const T xBottom = a.first + (bottom - a.second) * (b.first - a.first) / (b.second - a.second);
+                const T xTop    = a.first + (top - a.second) * (b.first - a.first) / (b.second - a.second);
+                x0              = std::min(xBottom, xTop);
+                x1              = std::max(xBottom, xTop);
+            }
+            for (int x = cellX(x0); x <= cellX(x1); ++x)
+                m_cells[y * m_nx + x].push_back(e);
+        }
+    }
+
+    // Inside flag of the cell centers, with one horizontal scanline per row
+    m_centerInside.assign(m_cells.size(), 0);
+    std::vector<T> crossings;
+    for (int y = 0; y < m_ny; ++y)
+    {
+        const T centerY = m_minY + (y + T(0.5)) * m_cellSize;
+        crossings.clear();
+        for (const Edge& edge : m_edges)
+        {
+            if ((edge.a.second > centerY) != (edge.b.second > centerY))
+                crossings.push_back(edge.a.first + (centerY - edge.a.second) * (edge.b.first - edge.a.first) / (edge.b.second - edge.a.second));
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        std::size_t nbrBefore = 0; // Crossings on the left of the current center
+        for (int x = 0; x < m_nx; ++x)
+        {
+            const T centerX = m_minX + (x + T(0.5)) * m_cellSize;
+            while (nbrBefore < crossings.size() && crossings[nbrBefore] < centerX)
+                nbrBefore++;
+            m_centerInside[y * m_nx + x] = static_cast<char>(nbrBefore % 2);
+        }
+    }
+}
+
+template<typename T>
+bool Domain<T>::contains(const Point& p) const
+{
+    if (empty() || p.first < m_minX || p.first > m_maxX || p.second < m_minY || p.second > m_maxY)
+        return false;
+
+    // Walk from the center of the cell, whose side is known, to p : only the edges of this cell can be crossed
+    const int   cx     = cellX(p.first);
+    const int   cy     = cellY(p.second);
+    const Point center(m_minX + (cx + T(0.5)) * m_cellSize, m_minY + (cy + T(0.5)) * m_cellSize);
+    bool        inside = m_centerInside[cy * m_nx + cx] != 0;
+    for (const int e : m_cells[cy * m_nx + cx])
+    {
+        const Point& a = m_edges[e].a;
+        const Point& b = m_edges[e].b;
+        if ((orientation(a, b, center) > 0) != (orientation(a, b, p) > 0) && (orientation(center, p, a) > 0) != (orientation(center, p, b) > 0))
+            inside = !inside;
+    }
+    return inside;
+}
+
+template<typename T>
+void Domain<T>::edgesInBox(T minX, T minY, T maxX, T maxY, std::vector<int>& result) const
+{
+    result.clear();
+    if (empty() || maxX < m_minX || minX > m_maxX || maxY < m_minY || minY > m_maxY)
+        return;
+
+    for (int y = cellY(minY); y <= cellY(maxY); ++y)
+    {
+        for (int x = cellX(minX); x <= cellX(maxX); ++x)
+        {
+            const auto& cell = m_cells[y * m_nx + x];
+            result.insert(result.end(), cell.begin(), cell.end());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+
+template<typename T>
+void Domain<T>::insideIntervals(const Point& a, const Point& b, std::vector<double>& intervals) const
+{
+    std::vector<int> candidates;
+    edgesInBox(std::min(a.first, b.first), std::min(a.second, b.second), std::max(a.first, b.first), std::max(a.second, b.second), candidates);
+
+    // Cut the segment where it crosses the edges, then keep the pieces whose middle is inside
+    const double        dx = static_cast<double>(b.first) - a.first;
+    const double        dy = static_cast<double>(b.second) - a.second;
+    std::vector<double> cuts{0., 1.};
+    for (const int e : candidates)
+    {
+        const double fx          = static_cast<double>(m_edges[e].b.first) - m_edges[e].a.first;
+        const double fy          = static_cast<double>(m_edges[e].b.second) - m_edges[e].a.second;
+        const double denominator = dx * fy - dy * fx;
+        if (denominator == 0)
+            continue; // Parallel
+        const double acX = static_cast<double>(m_edges[e].a.first) - a.first;
+        const double acY = static_cast<double>(m_edges[e].a.second) - a.second;
+        const double t   = (acX * fy - acY * fx) / denominator; // Position on the segment
+        const double u   = (acX * dy - acY * dx) / denominator; // Position on the edge
+        if (t > 0 && t < 1 && u >= 0 && u <= 1)
+            cuts.push_back(t);
+    }
+    std::sort(cuts.begin(), cuts.end());
+
+    for (std::size_t k = 0; k + 1 < cuts.size(); ++k)
+    {
+        const double middle = (cuts[k] + cuts[k + 1]) / 2;
+        if (cuts[k + 1] > cuts[k] && contains({static_cast<T>(a.first + middle * dx), static_cast<T>(a.second + middle * dy)}))
+        {
+            intervals.push_back(cuts[k]);
+            intervals.push_back(cuts[k + 1]);
+        }
+    }
+}
+
+template<typename T>
+typename Domain<T>::Point Domain<T>::closestBorderPoint(const Point& p) const
+{
+    if (empty())
+        return p;
+
+    // Look at the edges in a box around p, doubled until the closest edge found is nearer than the half side of the box
+    Point            best     = m_edges[0].a;
+    double           bestDist = -1;
+    std::vector<int> candidates;
+    for (T halfSide = m_cellSize;; halfSide *= 2)
+    {
+        edgesInBox(p.first - halfSide, p.second - halfSide, p.first + halfSide, p.second + halfSide, candidates);
+        for (const int e : candidates)
+        {
+            const Point& a  = m_edges[e].a;
+            const double dx = static_cast<double>(m_edges[e].b.first) - a.first;
+            const double dy = static_cast<double>(m_edges[e].b.second) - a.second;
+            const double l2 = dx * dx + dy * dy;
+            const double t  = l2 > 0 ? std::clamp(((p.first - a.first) * dx + (p.second - a.second) * dy) / l2, 0., 1.) : 0.;
+            const Point  q(static_cast<T>(a.first + t * dx), static_cast<T>(a.second + t * dy));
+            const double d = std::hypot(static_cast<double>(q.first) - p.first, static_cast<double>(q.second) - p.second);
+            if (bestDist < 0 || d < bestDist)
+            {
+                bestDist = d;
+                best     = q;
+            }
+        }
+        const bool coversGrid = p.first - halfSide <= m_minX && p.first + halfSide >= m_maxX && p.second - halfSide <= m_minY && p.second + halfSide >= m_maxY;
+        if ((bestDist >= 0 && bestDist <= halfSide) || coversGrid)
+            return best;
+    }
+}
+
+template<typename T>
+std::vector<typename Domain<T>::Point> Domain<T>::borderPoints(int nbrPoints) const
+{
+    std::vector<Point> points;
+    if (m_rings.empty() || nbrPoints <= 0)
+        return points;
+
+    const Ring& outer     = m_rings[0];
+    double      perimeter = 0;
+    for (std::size_t i = 0; i < outer.size(); ++i)
+    {
+        const Point& a = outer[i];
+        const Point& b = outer[(i + 1) % outer.size()];
+        perimeter += std::hypot(static_cast<double>(b.first) - a.first, static_cast<double>(b.second) - a.second);
+    }
+
+    // Walk along the ring and drop a point every perimeter / nbrPoints
+    const double spacing = perimeter / nbrPoints;
+    double       next    = 0; // Curvilinear abscissa of the next point
+    double       walked  = 0;
+    for (std::size_t i = 0; i < outer.size() && static_cast<int>(points.size()) < nbrPoints; ++i)
+    {
+        const Point& a      = outer[i];
+        const Point& b      = outer[(i + 1) % outer.size()];
+        const double length = std::hypot(static_cast<double>(b.first) - a.first, static_cast<double>(b.second) - a.second);
+        while (next < walked + length && static_cast<int>(points.size()) < nbrPoints)
+        {
+            const double t = (next - walked) / length;
+            points.emplace_back(static_cast<T>(a.first + t * (b.first - a.first)), static_cast<T>(a.second + t * (b.second - a.second)));
+            next += spacing;
+        }
+        walked += length;
+    }
+    return points;
+}
+
+template class Domain<float>;
+template class Domain<double>;
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "memoryReport.hpp"
+
+// Polygonal domain of the graph : an outer ring and any number of holes, the domain being on the left of every edge
+// (outer ring counter-clockwise, holes clockwise). The edges are indexed by a uniform grid which stores, for each cell,
+// the edges crossing it and whether its center is inside, so an inside test only looks at the few edges of one cell
+template<typename T>
+class Domain {
+public:
+    using Point = std::pair<T, T>;
+    using Ring  = std::vector<Point>;
+
+    struct Edge {
+        Point a; // Start of the edge, the domain is on the left of a -> b
+        Point b;
+    };
+
+    // Regular polygon of nbrSegments edges approximating the disc of the given radius centered on the origin
+    static Domain disc(T radius, int nbrSegments);
+
+    // Read the rings of a text file : one "x y" vertex per line, the rings separated by an empty line, the first ring being the outer border
+    // and the next ones the holes. Lines starting with # are comments. Returns false (and leaves the domain unchanged) on error
+    bool load(const std::string& path);
+
+    // Set the rings (the first one is the outer border, the others the holes), whatever their orientation, and build the edge grid
+    void setRings(std::vector<Ring> rings);
+
+    bool                     empty() const { return m_edges.empty(); }
+    const std::vector<Ring>& rings() const { return m_rings; }
+    const std::vector<Edge>& edges() const { return m_edges; }
+    T                        area() const { return m_area; }
+
+    T minX() const { return m_minX; }
+    T minY() const { return m_minY; }
+    T maxX() const { return m_maxX; }
+    T maxY() const { return m_maxY; }
+
+    bool contains(const Point& p) const;
+
+    // Indices of the edges which may cross the box [minX, maxX] x [minY, maxY], sorted and without duplicates
+    void edgesInBox(T minX, T minY, T maxX, T maxY, std::vector<int>& result) const;
+
+    // Pieces of the segment a + t (b - a), t in [0, 1], inside the domain, as pairs (t0, t1) appended to intervals in increasing order
+    void insideIntervals(const Point& a, const Point& b, std::vector<double>& intervals) const;
+
+    // Closest point of the border of the domain to p
+    Point closestBorderPoint(const Point& p) const;
+
+    // Uniform random point of the domain, by rejection in the bounding box
+    template<typename Engine>
+    Point randomPoint(Engine& eng) const;
+
+    // nbrPoints points evenly spaced along the outer ring
+    std::vector<Point> borderPoints(int nbrPoints) const;
+
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage{"domain"};
+        usage.addNested(m_rings).add(m_edges).addNested(m_cells).add(m_centerInside);
+        return usage;
+    }
+
+private:
+    int cellX(T x) const;
+    int cellY(T y) const;
+
+    void buildGrid();
+
+    std::vector<Ring> m_rings;
+    std::vector<Edge> m_edges;
+    T                 m_area = 0;
+
+    T m_minX = 0;
+    T m_minY = 0;
+    T m_maxX = 0;
+    T m_maxY = 0;
+
+    T   m_cellSize = 1;
+    int m_nx       = 0; // Number of columns of the edge grid
+    int m_ny       = 0; // Number of rows of the edge grid
+
+    std::vector<std::vector<int>> m_cells;        // Edges crossing each cell
+    std::vector<char>             m_centerInside; // Whether the center of each cell is inside the domain
+};
+
+template<typename T>
+template<typename Engine>
+typename Domain<T>::Point Domain<T>::randomPoint(Engine& eng) const
+{
+    std::uniform_real_distribution<double> x(m_minX, m_maxX);
+    std::uniform_real_distribution<double> y(m_minY, m_maxY);
+    for (;;)
+    {
+        const Point p(static_cast<T>(x(eng)), static_cast<T>(y(eng)));
+        if (contains(p))
+            return p;
+    }
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <span>
+#include <utility>
+#include <vector>
+#include "domain.hpp"
+
+template<typename Real>
+using RealPoint = std::pair<Real, Real>;
+
+template<typename Real>
+inline Real cross(const RealPoint<Real>& u, const RealPoint<Real>& v)
+{
+    return u.first * v.second - u.second * v.first;
+}
+
+// Intersection of the convex polygon (counter-clockwise) with the domain, as the oriented segments of its border appended in pairs to out.
+// The border is made of the pieces of the edges of the polygon inside the domain and of the pieces of the edges of the domain inside the
+// polygon, both with the intersection on their left, so the area and the moments of the intersection are sums over the segments (Green)
+// even when it has several components. Only the edges of the domain near the polygon are looked at, through its edge grid
+template<typename Real, typename T>
+inline void clipConvexPolygonToDomain(std::span<const RealPoint<Real>> polygon, const Domain<T>& domain, std::vector<int>& candidates,
+                                      std::vector<Real>& cuts, std::vector<RealPoint<Real>>& out)
+{
+    const int n = static_cast<int>(polygon.size());
+
+    Real minX = polygon[0].first;
+    Real maxX = polygon[0].first;
+    Real minY = polygon[0].second;
+    Real maxY = polygon[0].second;
+    for (const auto& p : polygon)
+    {
+        minX = std::min(minX, p.first);
+        maxX = std::max(maxX, p.first);
+        minY = std::min(minY, p.second);
+        maxY = std::max(maxY, p.second);
+    }
+    domain.edgesInBox(static_cast<T>(minX), static_cast<T>(minY), static_cast<T>(maxX), static_cast<T>(maxY), candidates);
+
+    auto inside = [&](Real x, Real y) { return domain.contains({static_cast<T>(x), static_cast<T>(y)}); };
+
+    // Fast path : no border of the domain near the polygon, it is either fully inside or fully outside
+    if (candidates.empty())
+    {
+        RealPoint<Real> center(0, 0);
+        for (const auto& p : polygon)
+        {
+            center.first += p.first / n;
+            center.second += p.second / n;
+        }
+        if (!inside(center.first, center.second))
+            return;
+        for (int i = 0; i < n; ++i)
+        {
+            out.push_back(polygon[i]);
+            out.push_back(polygon[(i + 1) % n]);
+        }
+        return;
+    }
+
+    // Pieces of the edges of the polygon inside the domain : cut each edge where it crosses the border of the domain
+    for (int i = 0; i < n; ++i)
+    {
+        const RealPoint<Real>& a = polygon[i];
+        const RealPoint<Real>& b = polygon[(i + 1) % n];
+        const RealPoint<Real>  d(b.first - a.first, b.second - a.second);
+
+        cuts.assign({Real(0), Real(1)});
+        for (const int e : candidates)
+        {
+            const auto&           edge = domain.edges()[e];
+            const RealPoint<Real> c(edge.a.first, edge.a.second);
+            const RealPoint<Real> f(static_cast<Real>(edge.b.first) - c.first, static_cast<Real>(edge.b.second) - c.second);
+            const Real            denominator = cross(d, f);
+            if (denominator == 0)
+                continue; // Parallel edges
+            const RealPoint<Real> ac(c.first - a.first, c.second - a.second);
+            const Real            t = cross(ac, f) / denominator; // Position on the edge of the polygon
+            const Real            u = cross(ac, d) / denominator; // Position on the edge of the domain
+            if (t > 0 && t < 1 && u >= 0 && u <= 1)
+                cuts.push_back(t);
+        }
+        std::sort(cuts.begin(), cuts.end());
+
+        for (std::size_t k = 0; k + 1 < cuts.size(); ++k)
+        {
+            const Real t0 = cuts[k];
+            const Real t1 = cuts[k + 1];
+            if (t1 <= t0)
+                continue;
+            const Real middle = (t0 + t1) / 2;
+            if (inside(a.first + middle * d.first, a.second + middle * d.second))
+            {
+                out.emplace_back(a.first + t0 * d.first, a.second + t0 * d.second);
+                out.emplace_back(a.first + t1 * d.first, a.second + t1 * d.second);
+            }
+        }
+    }
+
+    // Pieces of the edges of the domain inside the polygon, clipped by the half-planes of the polygon (Cyrus-Beck)
+    for (const int e : candidates)
+    {
+        const auto&           edge = domain.edges()[e];
+        const RealPoint<Real> c(edge.a.first, edge.a.second);
+        const RealPoint<Real> f(static_cast<Real>(edge.b.first) - c.first, static_cast<Real>(edge.b.second) - c.second);
+
+        Real tIn  = 0;
+        Real tOut = 1;
+        for (int i = 0; i < n && tIn < tOut; ++i)
+        {
+            const RealPoint<Real>& a = polygon[i];
+            const RealPoint<Real>& b = polygon[(i + 1) % n];
+            const RealPoint<Real>  d(b.first - a.first, b.second - a.second);
+            const Real             distance = cross(d, RealPoint<Real>(c.first - a.first, c.second - a.second)); // >= 0 on the inside
+            const Real             speed    = cross(d, f);
+            if (speed == 0)
+            {
+                if (distance < 0)
+                    tOut = tIn; // Parallel and outside
+                continue;
+            }
+            const Real t = -distance / speed;
+            if (speed > 0)
+                tIn = std::max(tIn, t);
+            else
+                tOut = std::min(tOut, t);
+        }
+        if (tIn < tOut)
+        {
+            out.emplace_back(c.first + tIn * f.first, c.second + tIn * f.second);
+            out.emplace_back(c.first + tOut * f.first, c.second + tOut * f.second);
+        }
+    }
+}
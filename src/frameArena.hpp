@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+// Bump allocator for the short-lived temporaries of one iteration.
+// Allocations are carved out of a buffer which is kept from one iteration to the next and rewound by reset().
+// When an iteration needs more than the buffer, the extra memory comes from the heap and the buffer is grown at the next reset,
+// so once the size of an iteration is known the loop makes no heap allocation at all.
+class FrameArena : public std::pmr::memory_resource {
+public:
+    explicit FrameArena(std::size_t initialSize = 64 * 1024)
+        : m_buffer(initialSize) {}
+
+    FrameArena(const FrameArena&)            = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    ~FrameArena() override
+    {
+        releaseOverflow();
+    }
+
+    // Free everything allocated since the last reset, and grow the buffer if it was too small
+    void reset()
+    {
+        if (m_overflowBytes > 0)
+            m_buffer.resize(2 * (m_offset + m_overflowBytes));
+
+        releaseOverflow();
+        m_peak          = std::max(m_peak, m_offset + m_overflowBytes);
+        m_offset        = 0;
+        m_overflowBytes = 0;
+    }
+
+    std::size_t capacity() const { return m_buffer.size(); } // Size of the buffer
+    std::size_t used() const { return m_offset; }            // Bytes of the buffer used since the last reset
+    std::size_t peak() const { return m_peak; }              // Largest number of bytes used by one iteration
+
+private:
+    struct OverflowBlock {
+        void*       ptr;
+        std::size_t alignment;
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        const auto base    = reinterpret_cast<std::uintptr_t>(m_buffer.data());
+        const auto aligned = (base + m_offset + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+        const auto offset  = static_cast<std::size_t>(aligned - base);
+
+        if (offset + bytes <= m_buffer.size())
+        {
+            m_offset = offset + bytes;
+            return m_buffer.data() + offset;
+        }
+
+        // The buffer is full for this iteration : fall back on the heap, the buffer will be grown at the next reset
+        void* ptr = ::operator new(bytes, std::align_val_t{alignment});
+        m_overflow.push_back({ptr, alignment});
+        m_overflowBytes += bytes + alignment;
+        return ptr;
+    }
+
+    void do_deallocate(void* /*p*/, std::size_t /*bytes*/, std::size_t /*alignment*/) override
+    {
+        // Memory is only given back by reset()
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    void releaseOverflow()
+    {
+        for (const auto& block : m_overflow)
+            ::operator delete(block.ptr, std::align_val_t{block.alignment});
+        m_overflow.clear();
+    }
+
+    std::vector<std::byte>     m_buffer;            // Memory reused by every iteration
+    std::size_t                m_offset        = 0; // First free byte of the buffer
+    std::size_t                m_overflowBytes = 0; // Bytes which did not fit in the buffer during the current iteration
+    std::size_t                m_peak          = 0; // Largest number of bytes used by one iteration
+    std::vector<OverflowBlock> m_overflow;          // Heap blocks of the current iteration, freed by reset()
+};
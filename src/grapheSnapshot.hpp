@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "domain.hpp"
+#include "memoryReport.hpp"
+#include "pointStorage.hpp"
+
+// Immutable copy of the state of a graph needed to draw it, published by the optimizer after each iteration.
+// The renderer and the GUI panels read it while the next iteration mutates the graph.
+template<typename T>
+struct BasicGrapheSnapshot {
+    using Point  = std::pair<T, T>;
+    using Circle = std::pair<Point, T>;
+
+    BasicPointList<T>                 points;          // Points of the graph
+    std::vector<std::array<int, 3>>   triangles;       // Delaunay triangles, as indices in points
+    IndexLists                        cellTriangles;   // Triangles around each point, whose circumcenters are the vertices of its cell
+    std::vector<int>                  cellSuccessors;  // Next entry of each entry of cellTriangles in counter-clockwise order (-1 if none)
+    BasicCellList<T>                  clippedCells;    // Border segments of the cells clipped to the domain, empty if the clipping is disabled or the cells are not drawn
+    std::shared_ptr<const Domain<T>>  domain;          // Loaded domain, shared with the graph (nullptr for the disc)
+    BasicPointList<T>                 circumcenters;   // Circumcenter of each triangle, every Voronoi vertex once
+    std::vector<Circle>               triangleCircles; // Circumcircle of each triangle
+    std::vector<std::array<Point, 4>> orientedBoxes;   // Oriented bounding boxes of the last centralisation
+
+    int         nbrCentralisation      = 0; // Number of centralisations applied when the snapshot was taken
+    std::size_t nbrSeparatedDuplicates = 0; // Number of near-duplicate points separated before the last triangulation
+    int         capacitySteps          = -1; // Newton steps of the last capacity solve, -1 without the capacity constraint
+    double      capacityError          = 0;  // Largest relative error on the mass of a cell after the last capacity solve
+
+    MemoryUsage memoryUsage(std::string name) const
+    {
+        MemoryUsage usage{std::move(name)};
+        usage.addBlock(sizeof(*this)); // The snapshot itself, allocated by make_shared
+        usage.add(points.x).add(points.y).add(points.flags).add(triangles);
+        usage.add(cellTriangles.offsets).add(cellTriangles.indices).add(cellSuccessors);
+        usage.add(clippedCells.offsets).add(clippedCells.x).add(clippedCells.y);
+        usage.add(circumcenters.x).add(circumcenters.y).add(circumcenters.flags);
+        usage.add(triangleCircles).add(orientedBoxes);
+        return usage;
+    }
+};
@@ -33,6 +33,38 @@ void App::render2D()
         flipDelaunay = true;  // Set the graph to use Welzl's algorithm for flip Delaunay
     }
 
+    bool clipCells = graphe.clipCells;
+    if (ImGui::Checkbox("Clip cells to the domain", &clipCells))
+    {
+        waitIteration(); // The iteration reads the clipped cells
+        graphe.clipCells = clipCells;
+        graphe.clippingGeneration++; // Clip the current cells, or drop the clipped ones, when they are needed
+        graphe.publishSnapshot();
+    }
+
+    bool capacityConstrained = graphe.capacityConstrained;
+    if (ImGui::Checkbox("Capacity constrained (cells of equal mass)", &capacityConstrained))
+    {
+        waitIteration(); // The iteration solves the weights
+        graphe.capacityConstrained = capacityConstrained;
+        if (capacityConstrained && !graphe.clipCells)
+        {
+            graphe.clipCells = true; // The masses are the ones of the clipped cells
+            graphe.clippingGeneration++;
+        }
+        else
+            graphe.powerWeights.clear(); // Back to the Voronoi cells
+        graphe.doDelaunayAndCalculateCenters();
+        graphe.publishSnapshot();
+    }
+
+    bool jacobiSweep = graphe.jacobiSweep;
+    if (ImGui::Checkbox("Parallel sweep (Jacobi)", &jacobiSweep))
+    {
+        waitIteration(); // The iteration reads the sweep mode
+        graphe.jacobiSweep = jacobiSweep;
+    }
+
     if (ImGui::Button("Apply Centralisation"))
     {
         itrCentralisation += 1; // Set the counter to 1 for centralisation
@@ -57,10 +89,12 @@ void App::render2D()
         itrCentralisation = 1; // Set the counter to 1000 for centralisation
     }
 
-    ImGui::Text("Current centralisation method: %s", graphe.useWelzl ? "Welzl Circle" : (graphe.useCentroid ? "Centroid" : "Square"));
+    ImGui::Text("Current centralisation method: %s", graphe.useRaster ? "Raster" : graphe.useWelzl ? "Welzl Circle" : graphe.useAnisotropic ? "Anisotropic centroid" : (graphe.useCentroid ? "Centroid" : "Square"));
 
     if (ImGui::Button("Switch to Square"))
     {
+        waitIteration(); // The iteration reads the method flags
+
         graphe.nbrCentralisation = 0;     // Reset the number of centralisations
         itrCentralisation        = 0;     // Reset the centralisation counter
         graphe.useWelzl          = false; // Toggle the use of Welzl's algorithm
@@ -69,9 +103,13 @@ void App::render2D()
         graphe.kNearest          = false; // Toggle the use of k-nearest neighbors
         graphe.useOrientedBox    = false; // Toggle the use of oriented bounding box
         graphe.useMean           = false; // Toggle the use of mean calculation
+        graphe.useRaster         = false; // Toggle the use of the raster cells
+        graphe.useAnisotropic    = false; // Toggle the use of the anisotropic cells
     }
     if (ImGui::Button("Switch to Welzl Circle"))
     {
+        waitIteration(); // The iteration reads the method flags
+
         graphe.nbrCentralisation = 0;     // Reset the number of centralisations
         itrCentralisation        = 0;     // Reset the centralisation counter
         graphe.useWelzl          = true;  // Toggle the use of Welzl's algorithm
@@ -80,9 +118,13 @@ void App::render2D()
         graphe.kNearest          = false; // Toggle the use of k-nearest neighbors
         graphe.useOrientedBox    = false; // Toggle the use of oriented bounding box
         graphe.useMean           = false; // Toggle the use of mean calculation
+        graphe.useRaster         = false; // Toggle the use of the raster cells
+        graphe.useAnisotropic    = false; // Toggle the use of the anisotropic cells
     }
     if (ImGui::Button("Switch to Centroid"))
     {
+        waitIteration(); // The iteration reads the method flags
+
         graphe.nbrCentralisation = 0;     // Reset the number of centralisations
         itrCentralisation        = 0;     // Reset the centralisation counter
         graphe.useWelzl          = false; // Toggle the use of Welzl's algorithm
@@ -91,9 +133,13 @@ void App::render2D()
         graphe.kNearest          = false; // Toggle the use of k-nearest neighbors
         graphe.useOrientedBox    = false; // Toggle the use of oriented bounding box
         graphe.useMean           = false; // Toggle the use of mean calculation
+        graphe.useRaster         = false; // Toggle the use of the raster cells
+        graphe.useAnisotropic    = false; // Toggle the use of the anisotropic cells
     }
     if (ImGui::Button("Switch to k-nearest"))
     {
+        waitIteration(); // The iteration reads the method flags
+
         graphe.nbrCentralisation = 0;     // Reset the number of centralisations
         itrCentralisation        = 0;     // Reset the centralisation counter
         graphe.useWelzl          = false; // Toggle the use of Welzl's algorithm
@@ -102,9 +148,13 @@ void App::render2D()
         graphe.kNearest          = true;  // Toggle the use of k-nearest neighbors
         graphe.useOrientedBox    = false; // Toggle the use of oriented bounding box
         graphe.useMean           = false; // Toggle the use of mean calculation
+        graphe.useRaster         = false; // Toggle the use of the raster cells
+        graphe.useAnisotropic    = false; // Toggle the use of the anisotropic cells
     }
     if (ImGui::Button("Switch to oriented bounding box"))
     {
+        waitIteration(); // The iteration reads the method flags
+
         graphe.nbrCentralisation = 0;     // Reset the number of centralisations
         itrCentralisation        = 0;     // Reset the centralisation counter
         graphe.useWelzl          = false; // Toggle the use of Welzl's algorithm
@@ -113,9 +163,20 @@ void App::render2D()
         graphe.kNearest          = false; // Toggle the use of k-nearest neighbors
         graphe.useOrientedBox    = true;  // Toggle the use of oriented bounding box
         graphe.useMean           = false; // Toggle the use of mean calculation
+        graphe.useRaster         = false; // Toggle the use of the raster cells
+        graphe.useAnisotropic    = false; // Toggle the use of the anisotropic cells
+    }
+    ImGui::SameLine();
+    bool minimumAreaBox = graphe.useMinimumAreaBox;
+    if (ImGui::Checkbox("Minimum area box", &minimumAreaBox))
+    {
+        waitIteration(); // The iteration reads the method flags
+        graphe.useMinimumAreaBox = minimumAreaBox;
     }
     if (ImGui::Button("Switch to mean"))
     {
+        waitIteration(); // The iteration reads the method flags
+
         graphe.nbrCentralisation = 0;     // Reset the number of centralisations
         itrCentralisation        = 0;     // Reset the centralisation counter
         graphe.useWelzl          = false; // Toggle the use of Welzl's algorithm
@@ -124,6 +185,46 @@ void App::render2D()
         graphe.kNearest          = false; // Toggle the use of k-nearest neighbors
         graphe.useOrientedBox    = false; // Toggle the use of oriented bounding box
         graphe.useMean           = true;  // Toggle the use of mean calculation
+        graphe.useRaster         = false; // Toggle the use of the raster cells
+        graphe.useAnisotropic    = false; // Toggle the use of the anisotropic cells
+    }
+    if (ImGui::Button("Switch to raster (jump flooding)"))
+    {
+        waitIteration(); // The iteration reads the method flags
+
+        graphe.nbrCentralisation = 0;     // Reset the number of centralisations
+        itrCentralisation        = 0;     // Reset the centralisation counter
+        graphe.useWelzl          = false; // Toggle the use of Welzl's algorithm
+        graphe.useCentroid       = false; // Toggle the use of centroid calculation
+        graphe.useSquare         = false; // Toggle the use of square calculation
+        graphe.kNearest          = false; // Toggle the use of k-nearest neighbors
+        graphe.useOrientedBox    = false; // Toggle the use of oriented bounding box
+        graphe.useMean           = false; // Toggle the use of mean calculation
+        graphe.useRaster         = true;  // Toggle the use of the raster cells
+        graphe.useAnisotropic    = false; // Toggle the use of the anisotropic cells
+    }
+
+    if (ImGui::Button("Switch to anisotropic centroid"))
+    {
+        waitIteration(); // The iteration reads the method flags
+
+        graphe.nbrCentralisation = 0;     // Reset the number of centralisations
+        itrCentralisation        = 0;     // Reset the centralisation counter
+        graphe.useWelzl          = false; // Toggle the use of Welzl's algorithm
+        graphe.useCentroid       = false; // Toggle the use of centroid calculation
+        graphe.useSquare         = false; // Toggle the use of square calculation
+        graphe.kNearest          = false; // Toggle the use of k-nearest neighbors
+        graphe.useOrientedBox    = false; // Toggle the use of oriented bounding box
+        graphe.useMean           = false; // Toggle the use of mean calculation
+        graphe.useRaster         = false; // Toggle the use of the raster cells
+        graphe.useAnisotropic    = true;  // Toggle the use of the anisotropic cells
+    }
+
+    int rasterResolution = graphe.rasterResolution;
+    if (ImGui::SliderInt("Raster resolution", &rasterResolution, 64, 4096))
+    {
+        waitIteration(); // The iteration reads the resolution
+        graphe.rasterResolution = rasterResolution;
     }
 
     ImGui::Text("Center of Point 0 with Welzl Circle : ");
@@ -133,10 +234,27 @@ void App::render2D()
 
     ImGui::End();
 
+    const std::shared_ptr<const Graphe::Snapshot> snapshot = graphe.snapshot(); // The graph may be in the middle of an iteration
+
     ImGui::Begin("Graph Parameters");
-    ImGui::Text("Number of centralisations applied: %d", graphe.nbrCentralisation);
-    ImGui::Text("Number of points in the graph: %zu", graphe.pointList.size());
-    ImGui::Text("Number of triangles: %zu", graphe.idxTriangles.size());
+    ImGui::Text("Number of centralisations applied: %d", snapshot->nbrCentralisation);
+    ImGui::Text("Number of points in the graph: %zu", snapshot->points.size());
+    ImGui::Text("Number of triangles: %zu", snapshot->triangles.size());
+    ImGui::Text("Near-duplicate points separated: %zu", snapshot->nbrSeparatedDuplicates);
+    if (snapshot->capacitySteps >= 0)
+        ImGui::Text("Capacity constraint: %d Newton steps, mass error %.2e", snapshot->capacitySteps, snapshot->capacityError);
+
+    if (ImGui::CollapsingHeader("Memory"))
+    {
+        if (!iteration.valid())
+            memoryReport = graphe.memory_report(); // The graph can only be read between two iterations
+
+        for (const auto& entry : memoryReport.entries)
+            ImGui::Text("%s : %.1f KB, %zu allocations", entry.name.c_str(), entry.bytes / 1024., entry.allocations);
+        ImGui::Text("Total : %.1f KB, %zu allocations", memoryReport.totalBytes() / 1024., memoryReport.totalAllocations());
+        if (memoryReport.nbrPoints > 0)
+            ImGui::Text("Per point : %zu bytes", memoryReport.totalBytes() / memoryReport.nbrPoints);
+    }
     if (ImGui::Button("Show Triangles"))
     {
         drawTriangles = !drawTriangles; // Toggle the drawing of triangles
@@ -144,7 +262,10 @@ void App::render2D()
 
     if (ImGui::Button("Show Cells"))
     {
+        waitIteration();                        // The snapshot is published again with the clipped cells, or without them
         drawCelluleBorder = !drawCelluleBorder; // Toggle the drawing of centers
+        graphe.publishClippedCells = drawCelluleBorder;
+        graphe.publishSnapshot();
     }
 
     if (ImGui::Button("Show Points"))
@@ -167,7 +288,12 @@ void App::render2D()
         drawOrientedBox = !drawOrientedBox; // Toggle the drawing of oriented bounding boxes
     }
 
-    ImGui::SliderFloat("Delta for centralisation", &graphe.step, 0.f, 1.f);
+    float step = graphe.step;
+    if (ImGui::SliderFloat("Delta for centralisation", &step, 0.f, 1.f))
+    {
+        waitIteration(); // The iteration reads the step
+        graphe.step = step;
+    }
 
     if (ImGui::Button("Point from mouse positiion"))
     {
@@ -183,9 +309,62 @@ void App::render2D()
         graphe.currentIdxEnergiePoint = 0;    // Reset the index of the point for which we want to calculate the CVT energy
     }
 
+    ImGui::InputText("Domain file", domainPath, sizeof(domainPath));
+    if (ImGui::Button("Load domain"))
+    {
+        waitIteration(); // The iteration clips the cells to the domain
+        if (graphe.loadDomain(domainPath))
+            nbrPointsChanged = true; // Regenerate the points inside the new domain
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Use disc domain") && graphe.domain)
+    {
+        waitIteration();
+        graphe.domain.reset();
+        graphe.clippingGeneration++;
+        nbrPointsChanged = true;
+    }
+
+    ImGui::InputText("Density image (PGM)", densityPath, sizeof(densityPath));
+    if (ImGui::Button("Load density"))
+    {
+        waitIteration(); // The iteration reads the moments of the cells
+        if (graphe.loadDensity(densityPath))
+            graphe.publishSnapshot();
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Uniform density") && !graphe.density.empty())
+    {
+        waitIteration();
+        graphe.density = {};
+        graphe.densityGeneration++;
+        graphe.publishSnapshot();
+    }
+    bool bilinearDensity = graphe.density.bilinear();
+    if (ImGui::Checkbox("Bilinear density", &bilinearDensity))
+    {
+        waitIteration();
+        graphe.density.setBilinear(bilinearDensity); // Constant on each pixel, or interpolated between the pixel centers
+        graphe.densityGeneration++;
+        graphe.publishSnapshot();
+    }
+
+    ImGui::InputText("Metric field", metricPath, sizeof(metricPath));
+    if (ImGui::Button("Load metric"))
+    {
+        waitIteration(); // The iteration reads the metric of the anisotropic cells
+        graphe.loadMetric(metricPath);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Isotropic metric") && !graphe.metric.empty())
+    {
+        waitIteration();
+        graphe.metric = {};
+    }
+
     ImGui::End();
 
-    ImGui::Begin("CVT Energie");
+    energyPanelVisible = ImGui::Begin("CVT Energie"); // Collapsed, the iterations do not compute the energies
     if (itrCentralisation == 0)
     {
         ImGui::Text("Choose a new point :");
@@ -199,7 +378,7 @@ void App::render2D()
                 std::uniform_int_distribution<size_t> distrib(0, graphe.pointList.size() - 1);
                 graphe.currentIdxEnergiePoint = static_cast<int>(distrib(gen));
 
-                if (std::find(graphe.idxPointBorder.begin(), graphe.idxPointBorder.end(), graphe.currentIdxEnergiePoint) != graphe.idxPointBorder.end())
+                if (graphe.pointList.hasFlag(graphe.currentIdxEnergiePoint, PointFlag::Fixed))
                 {
                     continue;
                 }
@@ -221,11 +400,6 @@ void App::render2D()
         save_energies_to_csv(graphe.energies, ASSETS_PATH + std::string{"PointExemple/pointListV0OrientedSquare.csv"}); // Save the energies to a CSV file
         ImGui::Text("Energies saved to CVTenergie.csv");
     }
-
-    if (itrCentralisation == 1)
-    {
-        graphe.currentCVTEnergie = graphe.calcul_CVT_energie(graphe.currentIdxEnergiePoint); // Calculate the CVT energy for the selected point
-    }
     ImGui::End();
 
     ImGui::Render();
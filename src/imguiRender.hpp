@@ -1,6 +1,7 @@
 #pragma once
 
 #include <imgui.h>
+#include <future>
 #include "LlyodCentralisation.hpp"
 #include "trackball/TrackBall.hpp"
 
@@ -25,6 +26,8 @@ private:
     bool drawCircles       = false; // Flag to control whether to draw circles in the render
     bool drawOrientedBox   = false; // Flag to control whether to draw the oriented bounding box
 
+    bool energyPanelVisible = true; // The "CVT Energie" panel was drawn expanded in the last frame, so the iterations record their energy
+
     bool trueDelaunay = true;
     bool flipDelaunay = false;
 
@@ -33,12 +36,30 @@ private:
 
     std::vector<Vertex> v;
 
+    MemoryReport memoryReport; // Last memory report of the graph, refreshed between two iterations
+
+    char domainPath[256] = ASSETS_PATH "domain/squareWithHole.txt"; // Domain file edited in the GUI
+    char densityPath[256] = ASSETS_PATH "density/radialGradient.pgm"; // Density image edited in the GUI
+    char metricPath[256] = ASSETS_PATH "metric/circularField.txt"; // Metric field edited in the GUI
+
+    std::future<void> iteration; // Centralisation iteration running in the background, the frames are drawn from the last snapshot meanwhile
+
+    void startIteration();
+    void waitIteration(); // Wait for the running iteration (if any) and upload its result, to call before modifying the graph
+    void uploadSnapshot(const Graphe::Snapshot& snapshot);
+
     // std::vector<glm::vec3> randomPositions;
 
 public:
     App()
         : io(ImGui::GetIO()) {};
 
+    ~App()
+    {
+        if (iteration.valid())
+            iteration.wait(); // The iteration uses the graph
+    }
+
     int get_itrCentralisation() const
     {
         return this->itrCentralisation; // Provide a way to access the current centralisation iteration
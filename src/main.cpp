@@ -12,6 +12,7 @@
 #include <cmath>
 #include <glm/glm.hpp>
 #include <iostream>
+#include <string>
 #include <vector>
 #include "glm/ext/vector_float3.hpp"
 #include "imguiRender.hpp"
@@ -47,8 +48,46 @@ static void size_callback(GLFWwindow* /*window*/, int width, int height)
 using Point     = std::pair<float, float>; // Représente un point (x, y)
 using Adjacency = std::pair<Point, Point>; // Représente une paire d'indices de points adjacents
 
-int main()
+// Run the centralisation without window and print the energy and the memory report, e.g. `DelaunayCVT --headless 5000 100 [domain.txt] [density.pgm] [metric.txt]`.
+// A metric field switches to the anisotropic centroids, an empty path skips a file
+static int run_headless(int nbrPoints, int nbrIterations, const std::string& domainPath, const std::string& densityPath, const std::string& metricPath)
 {
+    Graphe graphe;
+    if (!domainPath.empty() && !graphe.loadDomain(domainPath))
+        return 1;
+    if (!densityPath.empty() && !graphe.loadDensity(densityPath))
+        return 1;
+    if (!metricPath.empty())
+    {
+        if (!graphe.loadMetric(metricPath))
+            return 1;
+        graphe.useCentroid    = false;
+        graphe.useAnisotropic = true;
+    }
+    graphe.generateRandomPoints(nbrPoints, 20);
+    graphe.doDelaunayAndCalculateCenters();
+
+    for (int i = 0; i < nbrIterations; ++i)
+    {
+        graphe.centralisation();
+        graphe.doDelaunayAndCalculateCenters();
+        graphe.nbrCentralisation++;
+    }
+
+    std::cout << "CVT energie after " << graphe.nbrCentralisation << " centralisations: " << graphe.calcul_total_CVT_energie() << '\n';
+    graphe.memory_report().print(std::cout);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && std::string(argv[1]) == "--headless")
+    {
+        const int nbrPoints     = argc > 2 ? std::stoi(argv[2]) : 500;
+        const int nbrIterations = argc > 3 ? std::stoi(argv[3]) : 100;
+        return run_headless(nbrPoints, nbrIterations, argc > 4 ? argv[4] : "", argc > 5 ? argv[5] : "", argc > 6 ? argv[6] : "");
+    }
+
     /* Initialize the library */
     if (!glfwInit())
     {
@@ -0,0 +1,53 @@
+#include "memoryReport.hpp"
+#include "LlyodCentralisation.hpp"
+
+template<typename Precision>
+MemoryReport BasicGraphe<Precision>::memory_report() const
+{
+    MemoryReport report;
+    report.nbrPoints = pointList.size();
+
+    auto& entries = report.entries;
+    entries.push_back(MemoryUsage{"pointList"}.add(pointList.x).add(pointList.y).add(pointList.flags));
+    entries.push_back(spatialGrid.memoryUsage());
+    entries.push_back(MemoryUsage{"pointsAdjacentsIdx"}.addNested(pointsAdjacentsIdx)); // One heap block per point
+    entries.push_back(MemoryUsage{"cellTriangles"}.add(cellTriangles.offsets).add(cellTriangles.indices));
+    entries.push_back(MemoryUsage{"nearCellulePointsTriees / hullNeighbors"}.add(nearCellulePointsTriees).add(hullNeighbors));
+    entries.push_back(MemoryUsage{"previous triangles and rings"}.add(previousTriangles).add(previousCellTriangles.offsets).add(previousCellTriangles.indices).add(previousCellSuccessors));
+    entries.push_back(MemoryUsage{"clippedCells"}.add(clippedCells.offsets).add(clippedCells.x).add(clippedCells.y));
+    if (domain)
+        entries.push_back(domain->memoryUsage()); // Shared with the snapshots
+    if (discDomain)
+        entries.push_back(discDomain->memoryUsage());
+    entries.push_back(MemoryUsage{"nearCellulePointsList"}.add(nearCellulePointsList.x).add(nearCellulePointsList.y).add(nearCellulePointsList.flags));
+    entries.push_back(MemoryUsage{"celluleBorder"}.add(celluleBorder));
+    entries.push_back(MemoryUsage{"idxTriangles"}.add(idxTriangles));
+    entries.push_back(MemoryUsage{"triangleCircles"}.add(triangleCircles));
+    entries.push_back(MemoryUsage{"allCircles / allOrientedBoxes"}.add(allCircles).add(allOrientedBoxes));
+    entries.push_back(MemoryUsage{"kNearestPoints"}.add(kNearestPoints.offsets).add(kNearestPoints.x).add(kNearestPoints.y));
+    MemoryUsage kNearestBuffers{"kNearestScratch"};
+    kNearestBuffers.add(kNearestScratch);
+    for (const KNearestScratch& scratch : kNearestScratch)
+        kNearestBuffers.add(scratch.nearest).add(scratch.candidates);
+    entries.push_back(kNearestBuffers);
+    entries.push_back(MemoryUsage{"energies / separatedDuplicates"}.add(energies).add(separatedDuplicates));
+    entries.push_back(MemoryUsage{"centralisationArena"}.addBlock(centralisationArena.capacity()));
+    entries.push_back(MemoryUsage{"jacobiX / jacobiY"}.add(jacobiX).add(jacobiY));
+    entries.push_back(rasterVoronoi.memoryUsage());
+    entries.push_back(density.memoryUsage());
+    entries.push_back(metric.memoryUsage());
+    entries.push_back(MemoryUsage{"powerWeights"}.add(powerWeights));
+
+    if (const auto published = snapshot())
+        entries.push_back(published->memoryUsage("published snapshot"));
+    if (spareSnapshot)
+        entries.push_back(spareSnapshot->memoryUsage("spare snapshot"));
+
+    entries.push_back(triangulationMemory);
+
+    return report;
+}
+
+template struct BasicGraphe<FloatPrecision>;
+template struct BasicGraphe<DoublePrecision>;
+template struct BasicGraphe<MixedPrecision>;
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Memory used by one structure: the bytes include an estimate of the bookkeeping of the allocator for each heap block
+struct MemoryUsage {
+    std::string name;
+    std::size_t bytes       = 0; // Reserved bytes (capacity, not size) plus the allocator overhead
+    std::size_t allocations = 0; // Number of live heap blocks
+
+    // Estimated bookkeeping of malloc for each block (header and alignment padding)
+    static constexpr std::size_t allocationOverhead = 2 * sizeof(void*);
+
+    // Account for one contiguous container (std::vector, AlignedVector, pmr::vector...)
+    template<typename Vector>
+    MemoryUsage& add(const Vector& v)
+    {
+        if (v.capacity() > 0)
+        {
+            bytes += v.capacity() * sizeof(typename Vector::value_type) + allocationOverhead;
+            allocations++;
+        }
+        return *this;
+    }
+
+    // Account for a vector of vectors: the outer block and every inner one
+    template<typename Vector>
+    MemoryUsage& addNested(const Vector& v)
+    {
+        add(v);
+        for (const auto& inner : v)
+            add(inner);
+        return *this;
+    }
+
+    MemoryUsage& addBlock(std::size_t blockBytes)
+    {
+        bytes += blockBytes + allocationOverhead;
+        allocations++;
+        return *this;
+    }
+};
+
+struct MemoryReport {
+    std::vector<MemoryUsage> entries;
+    std::size_t              nbrPoints = 0; // Number of points of the graph, to give the footprint per point
+
+    std::size_t totalBytes() const
+    {
+        std::size_t total = 0;
+        for (const auto& entry : entries)
+            total += entry.bytes;
+        return total;
+    }
+
+    std::size_t totalAllocations() const
+    {
+        std::size_t total = 0;
+        for (const auto& entry : entries)
+            total += entry.allocations;
+        return total;
+    }
+
+    void print(std::ostream& out) const
+    {
+        out << "Memory report for " << nbrPoints << " points\n";
+        for (const auto& entry : entries)
+            out << "  " << entry.name << " : " << entry.bytes << " bytes, " << entry.allocations << " allocations\n";
+        out << "  Total : " << totalBytes() << " bytes, " << totalAllocations() << " allocations";
+        if (nbrPoints > 0)
+            out << ", " << totalBytes() / nbrPoints << " bytes per point";
+        out << '\n';
+    }
+};
@@ -0,0 +1,104 @@
+#include "metricField.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Next line of the file which is not empty nor a comment
+static bool readDataLine(std::istream& in, std::istringstream& line)
+{
+    std::string text;
+    while (std::getline(in, text))
+    {
+        const auto first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos || text[first] == '#')
+            continue;
+        line.clear();
+        line.str(text);
+        return true;
+    }
+    return false;
+}
+
+template<typename T>
+bool MetricField<T>::load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not open the metric field: " << path << '\n';
+        return false;
+    }
+
+    std::istringstream line;
+    int                width  = 0;
+    int                height = 0;
+    if (!readDataLine(file, line) || !(line >> width >> height) || width < 2 || height < 2)
+    {
+        std::cerr << "Invalid size in the metric field: " << path << '\n';
+        return false;
+    }
+
+    std::vector<Tensor> tensors(static_cast<std::size_t>(width) * height);
+    for (Tensor& tensor : tensors)
+    {
+        double angle   = 0;
+        double stretch = 1;
+        if (!readDataLine(file, line) || !(line >> angle >> stretch) || !(stretch > 0))
+        {
+            std::cerr << "The metric field is truncated or has an invalid node: " << path << '\n';
+            return false;
+        }
+
+        // M = u u^T / stretch + v v^T stretch, u = (cos, sin) and v = (-sin, cos)
+        const double ux = std::cos(angle);
+        const double uy = std::sin(angle);
+        tensor.a        = ux * ux / stretch + uy * uy * stretch;
+        tensor.b        = ux * uy / stretch - ux * uy * stretch;
+        tensor.c        = uy * uy / stretch + ux * ux * stretch;
+    }
+
+    m_width   = width;
+    m_height  = height;
+    m_tensors = std::move(tensors);
+    return true;
+}
+
+template<typename T>
+void MetricField<T>::setFrame(T minX, T minY, T maxX, T maxY)
+{
+    m_originX = minX;
+    m_originY = minY;
+    m_scaleX  = m_width > 1 ? (static_cast<double>(maxX) - minX) / (m_width - 1) : 1.;
+    m_scaleY  = m_height > 1 ? (static_cast<double>(maxY) - minY) / (m_height - 1) : 1.;
+}
+
+template<typename T>
+typename MetricField<T>::Tensor MetricField<T>::at(double x, double y) const
+{
+    if (empty())
+        return {};
+
+    const double u = std::clamp((x - m_originX) / m_scaleX, 0., m_width - 1.);
+    const double v = std::clamp((y - m_originY) / m_scaleY, 0., m_height - 1.);
+    const int    i = std::min(static_cast<int>(u), m_width - 2);
+    const int    j = std::min(static_cast<int>(v), m_height - 2);
+    const double s = u - i;
+    const double t = v - j;
+
+    const Tensor& t00 = m_tensors[static_cast<std::size_t>(j) * m_width + i];
+    const Tensor& t10 = m_tensors[static_cast<std::size_t>(j) * m_width + i + 1];
+    const Tensor& t01 = m_tensors[static_cast<std::size_t>(j + 1) * m_width + i];
+    const Tensor& t11 = m_tensors[static_cast<std::size_t>(j + 1) * m_width + i + 1];
+
+    const double w00 = (1 - s) * (1 - t);
+    const double w10 = s * (1 - t);
+    const double w01 = (1 - s) * t;
+    const double w11 = s * t;
+    return {w00 * t00.a + w10 * t10.a + w01 * t01.a + w11 * t11.a, w00 * t00.b + w10 * t10.b + w01 * t01.b + w11 * t11.b,
+            w00 * t00.c + w10 * t10.c + w01 * t01.c + w11 * t11.c};
+}
+
+template class MetricField<float>;
+template class MetricField<double>;
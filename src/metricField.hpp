@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "memoryReport.hpp"
+
+// Metric tensors sampled on a grid stretched over a rectangle of the plane, for the anisotropic cells. The distance from x to a point p is
+// sqrt((x - p)^T M (x - p)) with the metric M of p, so a cell is stretched along the eigenvector of the lowest eigenvalue of M.
+// The grid stores the symmetric tensors, interpolated bilinearly between the nodes (the tensors stay positive definite)
+template<typename T>
+class MetricField {
+public:
+    // Symmetric tensor [[a, b], [b, c]]
+    struct Tensor {
+        double a = 1;
+        double b = 0;
+        double c = 1;
+    };
+
+    // Read a text file : "width height" then one "angle stretch" line per node, the rows from the bottom one. The cells are stretched by the
+    // factor stretch (>= 1) along the direction angle (in radians), with M = u u^T / stretch + v v^T stretch for u the direction and v its
+    // normal, so the area of the cells does not change. Lines starting with # are comments. Returns false (and leaves the field unchanged) on
+    // error
+    bool load(const std::string& path);
+
+    bool empty() const { return m_tensors.empty(); }
+    int  width() const { return m_width; }
+    int  height() const { return m_height; }
+
+    // Rectangle of the plane covered by the grid, its corner nodes being on the corners of the rectangle
+    void setFrame(T minX, T minY, T maxX, T maxY);
+
+    // Metric at a point of the plane, the one of the nearest border node outside of the grid, the identity if the field is empty
+    Tensor at(double x, double y) const;
+
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage{"metricField"};
+        usage.add(m_tensors);
+        return usage;
+    }
+
+private:
+    int                 m_width  = 0;
+    int                 m_height = 0;
+    std::vector<Tensor> m_tensors; // Tensor of each node, the first row at the bottom
+
+    double m_originX = 0; // Position of the node (0, 0)
+    double m_originY = 0;
+    double m_scaleX  = 1; // Distance between two nodes
+    double m_scaleY  = 1;
+};
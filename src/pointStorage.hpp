@@ -0,0 +1,234 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <utility>
+#include <vector>
+
+using Point = std::pair<float, float>; // Représente un point (x, y)
+
+// Allocator returning memory aligned on Alignment bytes, so the coordinate arrays can be loaded with aligned SIMD instructions
+template<typename T, std::size_t Alignment = 32>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() = default;
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>& /*other*/) {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{Alignment}));
+    }
+
+    void deallocate(T* p, std::size_t /*n*/)
+    {
+        ::operator delete(p, std::align_val_t{Alignment});
+    }
+
+    template<typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>& /*other*/) const
+    {
+        return true;
+    }
+};
+
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Attributes of a point, combined in the flags word of BasicPointList
+namespace PointFlag {
+inline constexpr std::uint8_t None       = 0;
+inline constexpr std::uint8_t Border     = 1 << 0; // Point on the border of the domain, never moved by the centralisation
+inline constexpr std::uint8_t Pinned     = 1 << 1; // Point fixed by the user
+inline constexpr std::uint8_t Degenerate = 1 << 2; // Point whose cell could not be computed (Welzl failure, duplicate...)
+inline constexpr std::uint8_t Dirty      = 1 << 3; // Point moved since the last triangulation
+inline constexpr std::uint8_t Fixed      = Border | Pinned | Degenerate; // Points which are skipped by the centralisation
+} // namespace PointFlag
+
+// Structure-of-arrays storage of 2D points: the x and y coordinates live in two separate aligned arrays
+template<typename T>
+struct BasicPointList {
+    using Scalar = T;
+    using Point  = std::pair<T, T>;
+
+    AlignedVector<T>          x;     // x coordinate of each point
+    AlignedVector<T>          y;     // y coordinate of each point
+    std::vector<std::uint8_t> flags; // PointFlag bits of each point
+
+    // Bumped by every change of the set of points (clear, resize, emplace_back), so the indexes built on the points know they are stale.
+    // A bulk write to x/y which keeps the set must call touch() unless the indexes are updated point by point
+    std::uint64_t generation = 0;
+
+    std::size_t size() const { return x.size(); }
+    bool        empty() const { return x.empty(); }
+
+    void clear()
+    {
+        x.clear();
+        y.clear();
+        flags.clear();
+        ++generation;
+    }
+
+    void reserve(std::size_t n)
+    {
+        x.reserve(n);
+        y.reserve(n);
+        flags.reserve(n);
+    }
+
+    void resize(std::size_t n)
+    {
+        x.resize(n);
+        y.resize(n);
+        flags.resize(n, PointFlag::None);
+        ++generation;
+    }
+
+    void emplace_back(T px, T py, std::uint8_t pointFlags = PointFlag::None)
+    {
+        x.push_back(px);
+        y.push_back(py);
+        flags.push_back(pointFlags);
+        ++generation;
+    }
+
+    void touch() { ++generation; }
+
+    bool hasFlag(std::size_t i, std::uint8_t flag) const { return (flags[i] & flag) != 0; } // True if any of the bits of flag is set
+    void setFlag(std::size_t i, std::uint8_t flag) { flags[i] |= flag; }
+    void clearFlag(std::size_t i, std::uint8_t flag) { flags[i] &= static_cast<std::uint8_t>(~flag); }
+
+    // Remove flag from every point
+    void clearFlag(std::uint8_t flag)
+    {
+        for (auto& f : flags)
+            f &= static_cast<std::uint8_t>(~flag);
+    }
+
+    // Compatibility accessor for the GUI code which still reads points as (x, y) pairs
+    Point operator[](std::size_t i) const { return {x[i], y[i]}; }
+
+    void set(std::size_t i, const Point& p)
+    {
+        x[i] = p.first;
+        y[i] = p.second;
+    }
+
+    std::vector<Point> toPairs() const
+    {
+        std::vector<Point> points;
+        points.reserve(size());
+        for (std::size_t i = 0; i < size(); ++i)
+            points.emplace_back(x[i], y[i]);
+        return points;
+    }
+};
+
+// Flat (CSR) storage of one list of points per generator: the points of the list i are at [offsets[i], offsets[i + 1])
+template<typename T>
+struct BasicCellList {
+    using Scalar = T;
+    using Point  = std::pair<T, T>;
+
+    std::vector<int> offsets; // Start of each list in x/y, with one more entry for the end of the last list
+    AlignedVector<T> x;       // x coordinate of every point of every list
+    AlignedVector<T> y;       // y coordinate of every point of every list
+
+    std::size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    bool        empty() const { return size() == 0; }
+    int         begin(std::size_t i) const { return offsets[i]; }
+    int         end(std::size_t i) const { return offsets[i + 1]; }
+    int         count(std::size_t i) const { return offsets[i + 1] - offsets[i]; }
+
+    void clear()
+    {
+        offsets.clear();
+        x.clear();
+        y.clear();
+    }
+
+    // Prepare counts.size() lists whose sizes are given by counts, the points being written afterwards with set()
+    void allocate(std::span<const int> counts)
+    {
+        offsets.resize(counts.size() + 1);
+        offsets[0] = 0;
+        for (std::size_t i = 0; i < counts.size(); ++i)
+            offsets[i + 1] = offsets[i] + counts[i];
+        x.resize(offsets.back());
+        y.resize(offsets.back());
+    }
+
+    // Build the lists one after the other when their sizes are not known in advance : startLists(), then append() the points of a list and endList()
+    void startLists()
+    {
+        clear();
+        offsets.push_back(0);
+    }
+
+    void append(const Point& p)
+    {
+        x.push_back(p.first);
+        y.push_back(p.second);
+    }
+
+    void endList() { offsets.push_back(static_cast<int>(x.size())); }
+
+    Point point(std::size_t idx) const { return {x[idx], y[idx]}; }
+
+    void set(std::size_t idx, const Point& p)
+    {
+        x[idx] = p.first;
+        y[idx] = p.second;
+    }
+
+    // Compatibility accessor returning a copy of the list i, for the code paths which are not performance sensitive
+    std::vector<Point> operator[](std::size_t i) const
+    {
+        std::vector<Point> points;
+        points.reserve(count(i));
+        for (int j = begin(i); j < end(i); ++j)
+            points.emplace_back(x[j], y[j]);
+        return points;
+    }
+};
+
+// Flat (CSR) storage of one list of indices per generator: the indices of the list i are at [offsets[i], offsets[i + 1])
+struct IndexLists {
+    std::vector<int> offsets; // Start of each list in indices, with one more entry for the end of the last list
+    std::vector<int> indices; // Every index of every list
+
+    std::size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    bool        empty() const { return size() == 0; }
+    int         begin(std::size_t i) const { return offsets[i]; }
+    int         end(std::size_t i) const { return offsets[i + 1]; }
+    int         count(std::size_t i) const { return offsets[i + 1] - offsets[i]; }
+
+    void clear()
+    {
+        offsets.clear();
+        indices.clear();
+    }
+
+    // Prepare counts.size() lists whose sizes are given by counts, the indices being written afterwards
+    void allocate(std::span<const int> counts)
+    {
+        offsets.resize(counts.size() + 1);
+        offsets[0] = 0;
+        for (std::size_t i = 0; i < counts.size(); ++i)
+            offsets[i + 1] = offsets[i] + counts[i];
+        indices.resize(offsets.back());
+    }
+};
+
+using PointList = BasicPointList<float>;
+using CellList  = BasicCellList<float>;
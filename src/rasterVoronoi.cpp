@@ -0,0 +1,228 @@
+#include "rasterVoronoi.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+// Coordinate of the pixels which have no seed yet : far enough to lose against any seed, small enough for its square to stay finite
+constexpr float noSeed = 1e18f;
+
+template<typename T>
+void RasterVoronoi<T>::compute(const BasicPointList<T>& seeds, const Domain<T>& domain, std::uint64_t domainGeneration, int resolution, ThreadPool& pool)
+{
+    buildMask(domain, domainGeneration, resolution, pool);
+
+    const std::size_t nbrPixels = static_cast<std::size_t>(m_width) * m_height;
+    m_labels.assign(nbrPixels, -1);
+    m_seedX.assign(nbrPixels, noSeed);
+    m_seedY.assign(nbrPixels, noSeed);
+    m_nextLabels.resize(nbrPixels);
+    m_nextSeedX.resize(nbrPixels);
+    m_nextSeedY.resize(nbrPixels);
+    m_best.resize(nbrPixels);
+
+    // Each seed starts in the pixel which contains it, the closest one keeping a pixel shared by several seeds
+    for (int i = 0; i < static_cast<int>(seeds.size()); ++i)
+    {
+        const float       sx    = static_cast<float>((seeds.x[i] - m_minX) / m_pixelSize - T(0.5));
+        const float       sy    = static_cast<float>((seeds.y[i] - m_minY) / m_pixelSize - T(0.5));
+        const int         x     = std::clamp(static_cast<int>(std::lround(sx)), 0, m_width - 1);
+        const int         y     = std::clamp(static_cast<int>(std::lround(sy)), 0, m_height - 1);
+        const std::size_t pixel = static_cast<std::size_t>(y) * m_width + x;
+        const float       d     = (sx - x) * (sx - x) + (sy - y) * (sy - y);
+        const float       dOld  = (m_seedX[pixel] - x) * (m_seedX[pixel] - x) + (m_seedY[pixel] - y) * (m_seedY[pixel] - y);
+        if (d < dOld)
+        {
+            m_labels[pixel] = i;
+            m_seedX[pixel]  = sx;
+            m_seedY[pixel]  = sy;
+        }
+    }
+
+    // Steps N/2, N/4, ..., 1, then one more pass of step 1 which fixes most of the errors of the plain jump flooding
+    for (int step = static_cast<int>(std::bit_floor(static_cast<unsigned>(std::max(m_width, m_height)))) / 2; step >= 1; step /= 2)
+        jumpFloodingPass(step, pool);
+    jumpFloodingPass(1, pool);
+
+    accumulateCentroids(static_cast<int>(seeds.size()), pool);
+}
+
+template<typename T>
+void RasterVoronoi<T>::buildMask(const Domain<T>& domain, std::uint64_t domainGeneration, int resolution, ThreadPool& pool)
+{
+    resolution = std::max(resolution, 1);
+    if (m_maskGeneration == domainGeneration && m_maskResolution == resolution && !m_inside.empty())
+        return;
+
+    const T width  = domain.maxX() - domain.minX();
+    const T height = domain.maxY() - domain.minY();
+    m_pixelSize    = std::max(width, height) / static_cast<T>(resolution);
+    if (!(m_pixelSize > 0))
+        m_pixelSize = 1;
+    m_minX   = domain.minX();
+    m_minY   = domain.minY();
+    m_width  = std::max(1, static_cast<int>(std::ceil(width / m_pixelSize)));
+    m_height = std::max(1, static_cast<int>(std::ceil(height / m_pixelSize)));
+
+    m_inside.resize(static_cast<std::size_t>(m_width) * m_height);
+    pool.parallelFor(0, m_height, [&](int rowBegin, int rowEnd) {
+        for (int y = rowBegin; y < rowEnd; ++y)
+        {
+            const T centerY = m_minY + (y + T(0.5)) * m_pixelSize;
+            for (int x = 0; x < m_width; ++x)
+                m_inside[static_cast<std::size_t>(y) * m_width + x] = domain.contains({m_minX + (x + T(0.5)) * m_pixelSize, centerY});
+        }
+    });
+
+    m_maskGeneration = domainGeneration;
+    m_maskResolution = resolution;
+}
+
+template<typename T>
+void RasterVoronoi<T>::jumpFloodingPass(int step, ThreadPool& pool)
+{
+    const int width = m_width;
+    pool.parallelFor(0, m_height, [&](int rowBegin, int rowEnd) {
+        for (int y = rowBegin; y < rowEnd; ++y)
+        {
+            const std::size_t row    = static_cast<std::size_t>(y) * width;
+            float*            best   = m_best.data() + row; // Squared distance from each pixel of the row to its closest seed so far
+            int*              labels = m_nextLabels.data() + row;
+            float*            seedX  = m_nextSeedX.data() + row;
+            float*            seedY  = m_nextSeedY.data() + row;
+            const float       fy     = static_cast<float>(y);
+
+            // The pixel itself
+            for (int x = 0; x < width; ++x)
+            {
+                labels[x]      = m_labels[row + x];
+                seedX[x]       = m_seedX[row + x];
+                seedY[x]       = m_seedY[row + x];
+                const float dx = seedX[x] - static_cast<float>(x);
+                const float dy = seedY[x] - fy;
+                best[x]        = dx * dx + dy * dy;
+            }
+
+            // The 8 neighbors at a distance step : for a given offset, the candidates of the row are a contiguous range of a source row,
+            // and the selection is written without branch so the loop vectorizes
+            for (int oy = -1; oy <= 1; ++oy)
+            {
+                const int sourceY = y + oy * step;
+                if (sourceY < 0 || sourceY >= m_height)
+                    continue;
+                for (int ox = -1; ox <= 1; ++ox)
+                {
+                    if (ox == 0 && oy == 0)
+                        continue;
+                    const int          shift   = ox * step;
+                    const int          xBegin  = std::max(0, -shift);
+                    const int          xEnd    = std::min(width, width - shift);
+                    const std::size_t  source  = static_cast<std::size_t>(sourceY) * width + shift;
+                    const int*         sLabels = m_labels.data() + source;
+                    const float*       sSeedX  = m_seedX.data() + source;
+                    const float*       sSeedY  = m_seedY.data() + source;
+                    for (int x = xBegin; x < xEnd; ++x)
+                    {
+                        const float dx     = sSeedX[x] - static_cast<float>(x);
+                        const float dy     = sSeedY[x] - fy;
+                        const float d      = dx * dx + dy * dy;
+                        const bool  closer = d < best[x];
+                        best[x]            = closer ? d : best[x];
+                        labels[x]          = closer ? sLabels[x] : labels[x];
+                        seedX[x]           = closer ? sSeedX[x] : seedX[x];
+                        seedY[x]           = closer ? sSeedY[x] : seedY[x];
+                    }
+                }
+            }
+        }
+    });
+
+    m_labels.swap(m_nextLabels);
+    m_seedX.swap(m_nextSeedX);
+    m_seedY.swap(m_nextSeedY);
+}
+
+template<typename T>
+void RasterVoronoi<T>::accumulateCentroids(int nbrSeeds, ThreadPool& pool)
+{
+    // One band of rows per thread : the pixels of a cell are mostly consecutive along the rows, so a run of pixels of the same seed adds to
+    // the last sums of the band. The sums are sorted and merged by seed whenever they double, so a band holds about the seeds it touches
+    const int nbrBands = std::min(pool.size(), m_height);
+    const int bandRows = (m_height + nbrBands - 1) / nbrBands;
+    if (static_cast<int>(m_bandSums.size()) < nbrBands)
+        m_bandSums.resize(nbrBands);
+
+    auto merge = [](std::vector<CellSums>& sums) {
+        std::sort(sums.begin(), sums.end(), [](const CellSums& a, const CellSums& b) { return a.seed < b.seed; });
+        std::size_t merged = 0;
+        for (std::size_t k = 0; k < sums.size(); ++k)
+        {
+            if (merged > 0 && sums[merged - 1].seed == sums[k].seed)
+            {
+                sums[merged - 1].x += sums[k].x;
+                sums[merged - 1].y += sums[k].y;
+                sums[merged - 1].count += sums[k].count;
+            }
+            else
+                sums[merged++] = sums[k];
+        }
+        sums.resize(merged);
+    };
+
+    pool.parallelFor(0, nbrBands, [&](int bandBegin, int bandEnd) {
+        for (int band = bandBegin; band < bandEnd; ++band)
+        {
+            std::vector<CellSums>& sums       = m_bandSums[band];
+            std::size_t            mergedSize = 0;
+            sums.clear();
+            for (int y = band * bandRows; y < std::min(m_height, (band + 1) * bandRows); ++y)
+            {
+                const std::size_t row = static_cast<std::size_t>(y) * m_width;
+                for (int x = 0; x < m_width; ++x)
+                {
+                    const int label = m_labels[row + x];
+                    if (label < 0 || !m_inside[row + x])
+                        continue;
+                    if (sums.empty() || sums.back().seed != label)
+                        sums.push_back(CellSums{label, 0, 0, 0});
+                    sums.back().x += x;
+                    sums.back().y += y;
+                    sums.back().count++;
+                }
+                if (sums.size() > 2 * mergedSize + m_width)
+                {
+                    merge(sums);
+                    mergedSize = sums.size();
+                }
+            }
+            merge(sums);
+        }
+    });
+
+    m_sumX.assign(nbrSeeds, 0);
+    m_sumY.assign(nbrSeeds, 0);
+    m_counts.assign(nbrSeeds, 0);
+    pool.parallelFor(0, nbrSeeds, [&](int seedBegin, int seedEnd) {
+        for (int band = 0; band < nbrBands; ++band)
+        {
+            const std::vector<CellSums>& sums = m_bandSums[band];
+            auto                         first = std::lower_bound(sums.begin(), sums.end(), seedBegin, [](const CellSums& a, int seed) { return a.seed < seed; });
+            for (auto it = first; it != sums.end() && it->seed < seedEnd; ++it)
+            {
+                m_sumX[it->seed] += it->x;
+                m_sumY[it->seed] += it->y;
+                m_counts[it->seed] += it->count;
+            }
+        }
+    }, 1024);
+}
+
+template<typename T>
+typename RasterVoronoi<T>::Point RasterVoronoi<T>::centroid(int seed) const
+{
+    // Mean of the pixel centers of the cell
+    const double count = static_cast<double>(m_counts[seed]);
+    return {static_cast<T>(m_minX + (m_sumX[seed] / count + 0.5) * m_pixelSize), static_cast<T>(m_minY + (m_sumY[seed] / count + 0.5) * m_pixelSize)};
+}
+
+template class RasterVoronoi<float>;
+template class RasterVoronoi<double>;
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "domain.hpp"
+#include "memoryReport.hpp"
+#include "pointStorage.hpp"
+#include "threadPool.hpp"
+
+// Discrete Voronoi diagram of the seeds on a raster grid covering the bounding box of the domain, computed by jump flooding : each pass
+// looks at the 8 pixels at a distance step (halved at each pass) and keeps the closest of their seeds. The cost is a fixed number of
+// passes over the grid whatever the layout of the seeds, and the centroid of each cell is accumulated over the pixels of the domain.
+// Each pixel stores the coordinates of its seed next to its label, so the passes read contiguous rows and vectorize
+template<typename T>
+class RasterVoronoi {
+public:
+    using Point = std::pair<T, T>;
+
+    // Label every pixel of a grid of resolution pixels along the longer side of the domain, then accumulate the centroids of the cells.
+    // domainGeneration changes whenever the domain does (the clippingGeneration of the graph), the mask of the domain is kept until then
+    void compute(const BasicPointList<T>& seeds, const Domain<T>& domain, std::uint64_t domainGeneration, int resolution, ThreadPool& pool);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    const std::vector<int>& labels() const { return m_labels; } // Seed of each pixel, row by row (-1 if the grid has no seed)
+
+    bool  hasCentroid(int seed) const { return m_counts[seed] > 0; } // False for the seeds which have no pixel in the domain (or lost their pixel to a closer seed)
+    Point centroid(int seed) const;
+
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage{"rasterVoronoi"};
+        usage.add(m_labels).add(m_seedX).add(m_seedY).add(m_nextLabels).add(m_nextSeedX).add(m_nextSeedY).add(m_best).add(m_inside);
+        usage.addNested(m_bandSums).add(m_sumX).add(m_sumY).add(m_counts);
+        return usage;
+    }
+
+private:
+    void buildMask(const Domain<T>& domain, std::uint64_t domainGeneration, int resolution, ThreadPool& pool);
+    void jumpFloodingPass(int step, ThreadPool& pool);
+    void accumulateCentroids(int nbrSeeds, ThreadPool& pool);
+
+    int m_width     = 0;
+    int m_height    = 0;
+    T   m_minX      = 0;
+    T   m_minY      = 0;
+    T   m_pixelSize = 1;
+
+    // The mask depends on the domain and the resolution only, it is kept while they do not change
+    std::uint64_t m_maskGeneration = 0;
+    int           m_maskResolution = 0;
+
+    std::vector<int>          m_labels;                // Closest seed found for each pixel
+    AlignedVector<float>      m_seedX;                 // Coordinates of that seed in pixels
+    AlignedVector<float>      m_seedY;
+    std::vector<int>          m_nextLabels;            // Output of the current pass
+    AlignedVector<float>      m_nextSeedX;
+    AlignedVector<float>      m_nextSeedY;
+    AlignedVector<float>      m_best;                  // Squared distance from each pixel to its seed in the current pass, kept between the passes
+    std::vector<std::uint8_t> m_inside;                // Whether the center of each pixel is inside the domain
+
+    // Sums of the pixel coordinates of a cell over some of its pixels
+    struct CellSums {
+        int          seed  = -1;
+        std::int64_t x     = 0;
+        std::int64_t y     = 0;
+        std::int64_t count = 0;
+    };
+
+    // Sums of the pixel coordinates of each cell, in integers so the result does not depend on how the rows are shared between the threads.
+    // Each band of rows keeps the sums of the seeds it touches only, sorted by seed, so the buffers grow with the seeds and not with the
+    // seeds times the threads, and they are added up afterwards
+    std::vector<std::vector<CellSums>> m_bandSums;
+    std::vector<std::int64_t> m_sumX;
+    std::vector<std::int64_t> m_sumY;
+    std::vector<std::int64_t> m_counts;
+};
@@ -0,0 +1,292 @@
+#include "spatialGrid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+template<typename T>
+void SpatialGrid<T>::build(const BasicPointList<T>& points, T pointsPerCell)
+{
+    clear();
+    m_generation = points.generation;
+    if (points.empty())
+        return;
+
+    const auto [minX, maxX] = std::minmax_element(points.x.begin(), points.x.end());
+    const auto [minY, maxY] = std::minmax_element(points.y.begin(), points.y.end());
+    const T    width        = *maxX - *minX;
+    const T    height       = *maxY - *minY;
+    const T    n            = static_cast<T>(points.size());
+
+    // Cells of pointsPerCell points in average, or a single row/column if the points are aligned
+    m_cellSize = std::sqrt(width * height * pointsPerCell / n);
+    if (!(m_cellSize > 0))
+        m_cellSize = std::max(width, height) * pointsPerCell / n;
+    if (!(m_cellSize > 0))
+        m_cellSize = 1; // Every point at the same place
+
+    m_minX = *minX;
+    m_minY = *minY;
+    m_nx   = std::max(1, static_cast<int>(std::ceil(width / m_cellSize)));
+    m_ny   = std::max(1, static_cast<int>(std::ceil(height / m_cellSize)));
+
+    // Each cell gets room for several times its average number of points, so the moves of update() seldom grow a cell
+    m_cells.resize(static_cast<std::size_t>(m_nx) * m_ny);
+    const std::size_t cellCapacity = static_cast<std::size_t>(std::ceil(4 * std::max(pointsPerCell, T(1))));
+    for (auto& cell : m_cells)
+        cell.reserve(cellCapacity);
+    m_cellOfPoint.resize(points.size());
+    for (int i = 0; i < static_cast<int>(points.size()); ++i)
+    {
+        const int cell    = cellOf(points.x[i], points.y[i]);
+        m_cellOfPoint[i] = cell;
+        m_cells[cell].push_back(i);
+    }
+}
+
+template<typename T>
+void SpatialGrid<T>::update(const BasicPointList<T>& points, int idx)
+{
+    const int oldCell = m_cellOfPoint[idx];
+    const int newCell = cellOf(points.x[idx], points.y[idx]);
+    if (oldCell == newCell)
+        return; // Most moves stay in the same cell
+
+    auto& old = m_cells[oldCell];
+    *std::find(old.begin(), old.end(), idx) = old.back(); // The order inside a cell does not matter
+    old.pop_back();
+    m_cells[newCell].push_back(idx);
+    m_cellOfPoint[idx] = newCell;
+}
+
+template<typename T>
+void SpatialGrid<T>::update(const BasicPointList<T>& points, std::span<const int> moved)
+{
+    for (const int idx : moved)
+        update(points, idx);
+}
+
+template<typename T>
+void SpatialGrid<T>::clear()
+{
+    m_cells.clear();
+    m_cellOfPoint.clear();
+    m_nx         = 0;
+    m_ny         = 0;
+    m_generation = std::numeric_limits<std::uint64_t>::max();
+}
+
+template<typename T>
+int SpatialGrid<T>::cellX(T x) const
+{
+    const int cx = static_cast<int>(std::floor((x - m_minX) / m_cellSize));
+    return std::clamp(cx, 0, m_nx - 1);
+}
+
+template<typename T>
+int SpatialGrid<T>::cellY(T y) const
+{
+    const int cy = static_cast<int>(std::floor((y - m_minY) / m_cellSize));
+    return std::clamp(cy, 0, m_ny - 1);
+}
+
+template<typename T>
+template<typename Visitor>
+void SpatialGrid<T>::visitRing(int cx, int cy, int r, Visitor&& visit) const
+{
+    auto visitCell = [&](int x, int y) {
+        if (x < 0 || x >= m_nx || y < 0 || y >= m_ny)
+            return;
+        for (const int idx : m_cells[y * m_nx + x])
+            visit(idx);
+    };
+
+    if (r == 0)
+    {
+        visitCell(cx, cy);
+        return;
+    }
+
+    // Bottom and top rows, then the left and right columns without their corners
+    for (int x = cx - r; x <= cx + r; ++x)
+    {
+        visitCell(x, cy - r);
+        visitCell(x, cy + r);
+    }
+    for (int y = cy - r + 1; y <= cy + r - 1; ++y)
+    {
+        visitCell(cx - r, y);
+        visitCell(cx + r, y);
+    }
+}
+
+template<typename T>
+T SpatialGrid<T>::distanceOutsideBlock(const Point& p, int x0, int x1, int y0, int y1) const
+{
+    // The points which left the bounding box are stored in the border cells, so nothing lies beyond a side on the border of the grid
+    T d = std::numeric_limits<T>::infinity();
+    if (x0 > 0)
+        d = std::min(d, p.first - (m_minX + x0 * m_cellSize));
+    if (x1 < m_nx - 1)
+        d = std::min(d, m_minX + (x1 + 1) * m_cellSize - p.first);
+    if (y0 > 0)
+        d = std::min(d, p.second - (m_minY + y0 * m_cellSize));
+    if (y1 < m_ny - 1)
+        d = std::min(d, m_minY + (y1 + 1) * m_cellSize - p.second);
+    return std::max(d, T(0));
+}
+
+template<typename T>
+int SpatialGrid<T>::nearest(const BasicPointList<T>& points, const Point& p, int exclude) const
+{
+    if (empty())
+        return -1;
+
+    const int cx       = cellX(p.first);
+    const int cy       = cellY(p.second);
+    int       best     = -1;
+    T         bestDist = std::numeric_limits<T>::max();
+
+    for (int r = 0;; ++r)
+    {
+        visitRing(cx, cy, r, [&](int idx) {
+            if (idx == exclude)
+                return;
+            const T dx = points.x[idx] - p.first;
+            const T dy = points.y[idx] - p.second;
+            const T d  = dx * dx + dy * dy;
+            if (d < bestDist)
+            {
+                bestDist = d;
+                best     = idx;
+            }
+        });
+
+        // Stop when no unvisited cell can contain a closer point
+        const T outside = distanceOutsideBlock(p, cx - r, cx + r, cy - r, cy + r);
+        if (std::isinf(outside) || (best != -1 && bestDist <= outside * outside))
+            break;
+    }
+    return best;
+}
+
+template<typename T>
+void SpatialGrid<T>::kNearest(const BasicPointList<T>& points, const Point& p, int k, std::vector<int>& result, int exclude) const
+{
+    std::vector<std::pair<T, int>> candidates;
+    kNearest(points, p, k, result, candidates, exclude);
+}
+
+template<typename T>
+void SpatialGrid<T>::kNearest(const BasicPointList<T>& points, const Point& p, int k, std::vector<int>& result, std::vector<std::pair<T, int>>& candidates,
+                              int exclude) const
+{
+    result.clear();
+    candidates.clear();
+    if (empty() || k <= 0)
+        return;
+
+    const int cx = cellX(p.first);
+    const int cy = cellY(p.second);
+
+    // Max-heap of the k best candidates found so far, the farthest on top
+    auto& best = candidates;
+
+    for (int r = 0;; ++r)
+    {
+        visitRing(cx, cy, r, [&](int idx) {
+            if (idx == exclude)
+                return;
+            const T dx = points.x[idx] - p.first;
+            const T dy = points.y[idx] - p.second;
+            const T d  = dx * dx + dy * dy;
+            if (static_cast<int>(best.size()) < k)
+            {
+                best.emplace_back(d, idx);
+                std::push_heap(best.begin(), best.end());
+            }
+            else if (d < best.front().first)
+            {
+                std::pop_heap(best.begin(), best.end());
+                best.back() = {d, idx};
+                std::push_heap(best.begin(), best.end());
+            }
+        });
+
+        const T outside = distanceOutsideBlock(p, cx - r, cx + r, cy - r, cy + r);
+        if (std::isinf(outside) || (static_cast<int>(best.size()) == k && best.front().first <= outside * outside))
+            break;
+    }
+
+    std::sort_heap(best.begin(), best.end()); // Increasing distance
+    result.resize(best.size());
+    for (std::size_t i = 0; i < best.size(); ++i)
+        result[i] = best[i].second;
+}
+
+template<typename T>
+void SpatialGrid<T>::radius(const BasicPointList<T>& points, const Point& p, T r, std::vector<int>& result) const
+{
+    result.clear();
+    if (empty())
+        return;
+
+    const T r2 = r * r;
+    for (int y = cellY(p.second - r); y <= cellY(p.second + r); ++y)
+    {
+        for (int x = cellX(p.first - r); x <= cellX(p.first + r); ++x)
+        {
+            for (const int idx : m_cells[y * m_nx + x])
+            {
+                const T dx = points.x[idx] - p.first;
+                const T dy = points.y[idx] - p.second;
+                if (dx * dx + dy * dy <= r2)
+                    result.push_back(idx);
+            }
+        }
+    }
+}
+
+template<typename T>
+void SpatialGrid<T>::exactMatches(const BasicPointList<T>& points, const Point& p, T epsilon, std::vector<int>& result) const
+{
+    result.clear();
+    if (empty())
+        return;
+
+    for (int y = cellY(p.second - epsilon); y <= cellY(p.second + epsilon); ++y)
+    {
+        for (int x = cellX(p.first - epsilon); x <= cellX(p.first + epsilon); ++x)
+        {
+            for (const int idx : m_cells[y * m_nx + x])
+            {
+                if (std::abs(points.x[idx] - p.first) < epsilon && std::abs(points.y[idx] - p.second) < epsilon)
+                    result.push_back(idx);
+            }
+        }
+    }
+}
+
+template<typename T>
+int SpatialGrid<T>::exactMatch(const BasicPointList<T>& points, const Point& p, T epsilon) const
+{
+    if (empty())
+        return -1;
+
+    // The first match in index order, as the linear scan it replaces
+    int found = -1;
+    for (int y = cellY(p.second - epsilon); y <= cellY(p.second + epsilon); ++y)
+    {
+        for (int x = cellX(p.first - epsilon); x <= cellX(p.first + epsilon); ++x)
+        {
+            for (const int idx : m_cells[y * m_nx + x])
+            {
+                if ((found == -1 || idx < found) && std::abs(points.x[idx] - p.first) < epsilon && std::abs(points.y[idx] - p.second) < epsilon)
+                    found = idx;
+            }
+        }
+    }
+    return found;
+}
+
+template class SpatialGrid<float>;
+template class SpatialGrid<double>;
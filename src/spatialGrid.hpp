@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
+#include "memoryReport.hpp"
+#include "pointStorage.hpp"
+
+// Uniform grid over a BasicPointList, answering the spatial queries of the graph without scanning every point.
+// The grid covers the bounding box of the points at build time; a point which leaves it later is kept in the nearest border cell,
+// so the queries stay exact, they only get slower if many points leave the box (build again in that case).
+template<typename T>
+class SpatialGrid {
+public:
+    using Point = std::pair<T, T>;
+
+    // Index every point of points, with cells of about pointsPerCell points
+    void build(const BasicPointList<T>& points, T pointsPerCell = 2);
+
+    // Move the point idx to its current position in points, O(1)
+    void update(const BasicPointList<T>& points, int idx);
+    // Move the given points to their current position in points, O(moved.size())
+    void update(const BasicPointList<T>& points, std::span<const int> moved);
+
+    void clear();
+
+    MemoryUsage memoryUsage() const
+    {
+        MemoryUsage usage{"spatialGrid"};
+        usage.addNested(m_cells).add(m_cellOfPoint);
+        return usage;
+    }
+
+    std::size_t size() const { return m_cellOfPoint.size(); } // Number of indexed points
+    bool        isBuiltFor(const BasicPointList<T>& points) const { return m_generation == points.generation && size() == points.size(); }
+    bool        empty() const { return m_cellOfPoint.empty(); }
+
+    // Index of the closest point to p, -1 if the grid is empty. The point exclude is ignored
+    int nearest(const BasicPointList<T>& points, const Point& p, int exclude = -1) const;
+    // Indices of the k closest points to p, sorted by increasing distance. The point exclude is ignored
+    void kNearest(const BasicPointList<T>& points, const Point& p, int k, std::vector<int>& result, int exclude = -1) const;
+    // Same, the candidates being kept in the given buffer, so a caller running many queries (one buffer per thread) allocates nothing
+    void kNearest(const BasicPointList<T>& points, const Point& p, int k, std::vector<int>& result, std::vector<std::pair<T, int>>& candidates, int exclude) const;
+    // Indices of the points at a distance <= r of p
+    void radius(const BasicPointList<T>& points, const Point& p, T r, std::vector<int>& result) const;
+    // Indices of the points whose both coordinates are at less than epsilon of p (same test as Graphe::pointEqual)
+    void exactMatches(const BasicPointList<T>& points, const Point& p, T epsilon, std::vector<int>& result) const;
+    // First point matching p as in exactMatches, -1 if none
+    int exactMatch(const BasicPointList<T>& points, const Point& p, T epsilon) const;
+
+private:
+    int cellX(T x) const; // Column of the abscissa x, clamped to the grid
+    int cellY(T y) const; // Row of the ordinate y, clamped to the grid
+    int cellOf(T x, T y) const { return cellY(y) * m_nx + cellX(x); }
+
+    // Call visit(idx) for every point of the cells at a Chebyshev distance r of the cell (cx, cy)
+    template<typename Visitor>
+    void visitRing(int cx, int cy, int r, Visitor&& visit) const;
+
+    // Distance from p to the outside of the block of cells [x0, x1] x [y0, y1], infinite on the sides lying on the border of the grid
+    T distanceOutsideBlock(const Point& p, int x0, int x1, int y0, int y1) const;
+
+    T   m_minX     = 0;
+    T   m_minY     = 0;
+    T   m_cellSize = 1;
+    int m_nx       = 0; // Number of columns
+    int m_ny       = 0; // Number of rows
+
+    std::uint64_t m_generation = std::numeric_limits<std::uint64_t>::max(); // Generation of the points at build time, none when cleared
+
+    std::vector<std::vector<int>> m_cells;       // Indices of the points of each cell
+    std::vector<int>              m_cellOfPoint; // Cell of each point
+};
@@ -0,0 +1,89 @@
+#include "threadPool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int nbrThreads)
+{
+    if (nbrThreads <= 0)
+        nbrThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    m_workers.reserve(nbrThreads - 1); // The calling thread is the last one
+    for (int i = 0; i + 1 < nbrThreads; ++i)
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int, int)>& task, int minChunk)
+{
+    if (end <= begin)
+        return;
+
+    // About four chunks per thread, so a slow chunk does not keep the other threads waiting
+    const int count     = end - begin;
+    const int chunkSize = std::max({1, minChunk, count / (4 * size())});
+    const int nbrChunks = (count + chunkSize - 1) / chunkSize;
+    if (nbrChunks == 1 || m_workers.empty())
+    {
+        task(begin, end);
+        return;
+    }
+
+    std::lock_guard call(m_callMutex);
+    {
+        std::lock_guard lock(m_mutex);
+        m_task      = &task;
+        m_begin     = begin;
+        m_end       = end;
+        m_chunkSize = chunkSize;
+        m_nbrChunks = nbrChunks;
+        m_nextChunk = 0;
+        m_busy      = static_cast<int>(m_workers.size());
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    runChunks();
+
+    std::unique_lock lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busy == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::runChunks()
+{
+    for (int chunk = m_nextChunk++; chunk < m_nbrChunks; chunk = m_nextChunk++)
+    {
+        const int chunkBegin = m_begin + chunk * m_chunkSize;
+        (*m_task)(chunkBegin, std::min(m_end, chunkBegin + m_chunkSize));
+    }
+}
+
+void ThreadPool::workerLoop()
+{
+    std::uint64_t seen = 0; // Last loop run by this worker
+    for (;;)
+    {
+        {
+            std::unique_lock lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop)
+                return;
+            seen = m_generation;
+        }
+
+        runChunks();
+
+        std::lock_guard lock(m_mutex);
+        if (--m_busy == 0)
+            m_done.notify_one();
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads sleeping between two parallel loops, so a loop costs a wake-up instead of creating threads.
+// One loop runs at a time, and a task must not start another loop on the same pool
+class ThreadPool {
+public:
+    explicit ThreadPool(int nbrThreads = 0); // 0 : one thread per hardware thread, the calling thread included
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return static_cast<int>(m_workers.size()) + 1; } // Number of threads running a loop, the calling thread included
+
+    // Call task(chunkBegin, chunkEnd) on contiguous chunks of [begin, end) of at least minChunk indices, in parallel, the calling thread
+    // taking chunks too. Returns when every chunk is done
+    void parallelFor(int begin, int end, const std::function<void(int, int)>& task, int minChunk = 1);
+
+private:
+    void workerLoop();
+    void runChunks();
+
+    std::vector<std::thread> m_workers;
+    std::mutex               m_callMutex; // One loop at a time
+    std::mutex               m_mutex;
+    std::condition_variable  m_wake; // A new loop or the destruction
+    std::condition_variable  m_done; // The last worker finished its chunks
+
+    const std::function<void(int, int)>* m_task       = nullptr;
+    int                                  m_begin      = 0;
+    int                                  m_end        = 0;
+    int                                  m_chunkSize  = 1;
+    int                                  m_nbrChunks  = 0;
+    std::atomic<int>                     m_nextChunk  = 0;
+    int                                  m_busy       = 0; // Workers which have not finished the current loop
+    std::uint64_t                        m_generation = 0; // Number of loops started, a worker runs each loop once
+    bool                                 m_stop       = false;
+};
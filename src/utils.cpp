@@ -255,7 +255,7 @@ void save_energies_to_csv(const std::vector<double>& energies, const std::string
         return;
     }
 
-    for (int i = 0; i < energies.size(); ++i)
+    for (int i = 0; i < static_cast<int>(energies.size()); ++i)
     {
         if (i > 0)
         {
@@ -1,10 +1,13 @@
 #pragma once
 
 #include <array>
+#include <memory_resource>
 #include "glm/gtc/type_ptr.hpp"
 #include "object/sphere.hpp"
+#include "pointStorage.hpp"
 #include "shader/program.hpp"
 #include "trackball/TrackBall.hpp"
+#include "welzl.hpp"
 
 // Define a list of color glm::vec3
 constexpr glm::vec3 RED   = glm::vec3(1.0f, 0.0f, 0.0f);
@@ -111,8 +114,6 @@ struct GLobject {
     }
 };
 
-using Point = std::pair<float, float>; // Représente un point (x, y)
-
 void button_action(GLFWwindow* window, TrackballCamera* trackball, double& deltaTime);
 
 void draw_ball(TrackballCamera* trackball, const GLobject& sphere, const Program& program, GLFWwindow* window);
@@ -128,13 +129,12 @@ inline double determinant3x3(std::array<std::array<float, 3>, 3>& matrix)
     return matrix[0][0] * (matrix[1][1] * matrix[2][2] - matrix[1][2] * matrix[2][1]) - matrix[0][1] * (matrix[1][0] * matrix[2][2] - matrix[1][2] * matrix[2][0]) + matrix[0][2] * (matrix[1][0] * matrix[2][1] - matrix[1][1] * matrix[2][0]);
 }
 
-inline float distance(const std::pair<float, float>& p1, const std::pair<float, float>& p2)
+template<typename T>
+inline T distance(const std::pair<T, T>& p1, const std::pair<T, T>& p2)
 {
-    return std::sqrt(std::pow(p2.first - p1.first, 2) + std::pow(p2.second - p1.second, 2));
+    return std::sqrt((p2.first - p1.first) * (p2.first - p1.first) + (p2.second - p1.second) * (p2.second - p1.second));
 }
 
-std::pair<Point, float> welzl(std::vector<Point>& points, std::vector<Point>& boundary);
-
 void save_text_from_pointList(const std::vector<Point>& points, const std::string& destination);
 
 std::vector<Point> load_text_to_pointList(const std::string& source);
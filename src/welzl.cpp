@@ -1,87 +1,212 @@
-#include <iostream>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <random>
-#include "utils.hpp"
+#include <span>
+#include "welzl.hpp"
 
-// Define a random number generator
-static std::mt19937 gen(std::random_device{}());
+namespace {
 
-std::pair<Point, float> getCircle(std::vector<Point>& points)
+// Circle computed in double, converted once at the end
+struct WelzlCircle {
+    double x  = 0;
+    double y  = 0;
+    double r2 = 0; // Squared radius
+};
+
+template<typename T>
+bool contains(const WelzlCircle& circle, const std::pair<T, T>& p)
 {
-    if (points.size() == 0)
-        return {{0.f, 0.f}, 0.f}; // No points, return center at origin with radius 0
+    const double dx = p.first - circle.x;
+    const double dy = p.second - circle.y;
+    return dx * dx + dy * dy <= circle.r2 * (1 + 1e-9); // Relative tolerance : the points of the support are on the circle up to the rounding
+}
 
-    if (points.size() == 1)
-    {
-        // std::cout << "Calculating circle from 1 point: (" << points[0].first << ", " << points[0].second << ")\n";
-        return {points[0], 0.f}; // One point, return that point as center with radius 0
-    }
+template<typename T>
+WelzlCircle circleFrom2(const std::pair<T, T>& a, const std::pair<T, T>& b)
+{
+    const double x  = (static_cast<double>(a.first) + b.first) / 2;
+    const double y  = (static_cast<double>(a.second) + b.second) / 2;
+    const double dx = a.first - x;
+    const double dy = a.second - y;
+    return {x, y, dx * dx + dy * dy};
+}
+
+template<typename T>
+WelzlCircle circleFrom3(const std::pair<T, T>& a, const std::pair<T, T>& b, const std::pair<T, T>& c)
+{
+    // Circumcircle relative to a
+    const double bx = static_cast<double>(b.first) - a.first;
+    const double by = static_cast<double>(b.second) - a.second;
+    const double cx = static_cast<double>(c.first) - a.first;
+    const double cy = static_cast<double>(c.second) - a.second;
+    const double d  = 2 * (bx * cy - by * cx);
+    const double b2 = bx * bx + by * by;
+    const double c2 = cx * cx + cy * cy;
 
-    if (points.size() == 2)
+    // Collinear (or duplicate) points : the circle on the two farthest ones encloses the third
+    if (std::abs(d) <= 1e-12 * std::max(b2, c2))
     {
-        // std::cout << "Calculating circle from 2 points: (" << points[0].first << ", " << points[0].second << "), ("
-        //           << points[1].first << ", " << points[1].second << ")\n";
-        Point p1 = points[0];
-        Point p2 = points[1];
-        Point center((p1.first + p2.first) / 2., (p1.second + p2.second) / 2.);
-        float radius = distance(p1, center);
-        return {center, radius};
+        const double bc = (bx - cx) * (bx - cx) + (by - cy) * (by - cy);
+        if (bc >= b2 && bc >= c2)
+            return circleFrom2(b, c);
+        return b2 >= c2 ? circleFrom2(a, b) : circleFrom2(a, c);
     }
-    if (points.size() == 3)
-    {
-        Point a = points[0];
-        Point b = points[1];
-        Point c = points[2];
 
-        // Calcul du dénominateur
-        double d = 2 * (a.first * (b.second - c.second) + b.first * (c.second - a.second) + c.first * (a.second - b.second));
-
-        if (std::abs(d) < 1e-6)
-        {
-            // Les points sont probablement colinéaires → pas de cercle circonscrit
-            return {{0.f, 0.f}, 0.f};
-        }
+    const double ux = (cy * b2 - by * c2) / d;
+    const double uy = (bx * c2 - cx * b2) / d;
+    return {a.first + ux, a.second + uy, ux * ux + uy * uy};
+}
 
-        // Helper: norme² = x² + y²
-        auto norm = [](const Point& p) {
-            return p.first * p.first + p.second * p.second;
-        };
+} // namespace
 
-        double x = (norm(a) * (b.second - c.second) + norm(b) * (c.second - a.second) + norm(c) * (a.second - b.second)) / d;
+// Smallest circle enclosing the points, iterative form of Welzl's algorithm : each point outside of the current circle is on the border of
+// the circle of the points before it, which is rebuilt with it as support. The points are shuffled first (the expected time is linear for a
+// random order, quadratic for an adversarial one like the points of a cell in order) and every point found outside is moved to the front,
+// so the points which shaped the circle are tested first. The span is reordered in place, nothing is allocated
+template<typename T>
+std::pair<std::pair<T, T>, T> welzl(std::span<std::pair<T, T>> points, std::uint32_t seed)
+{
+    if (points.empty())
+        return {{0, 0}, -1}; // Negative radius : no circle
 
-        double y = (norm(a) * (c.first - b.first) + norm(b) * (a.first - c.first) + norm(c) * (b.first - a.first)) / d;
+    std::minstd_rand gen(seed + 1); // A zero seed is not allowed
+    std::shuffle(points.begin(), points.end(), gen);
 
-        Point center(static_cast<float>(x), static_cast<float>(y));
-        float radius = distance(center, a);
+    WelzlCircle circle{static_cast<double>(points[0].first), static_cast<double>(points[0].second), 0};
+    for (std::size_t i = 1; i < points.size(); ++i)
+    {
+        if (contains(circle, points[i]))
+            continue;
 
-        return {center, radius};
+        // Move to front : points[0] is the new support point, the others before it keep their order
+        std::rotate(points.begin(), points.begin() + i, points.begin() + i + 1);
+        const std::pair<T, T>& p = points[0];
+        circle                   = {static_cast<double>(p.first), static_cast<double>(p.second), 0};
+        for (std::size_t j = 1; j <= i; ++j)
+        {
+            if (contains(circle, points[j]))
+                continue;
+            circle = circleFrom2(p, points[j]);
+            for (std::size_t k = 1; k < j; ++k)
+            {
+                if (!contains(circle, points[k]))
+                    circle = circleFrom3(p, points[j], points[k]);
+            }
+        }
     }
-    std::cerr << "Error: Invalid number of points for circle calculation. Size: " << points.size() << '\n';
-    return {{0.f, 0.f}, 0.f}; // Return a default value in case of error
+
+    return {{static_cast<T>(circle.x), static_cast<T>(circle.y)}, static_cast<T>(std::sqrt(circle.r2))};
 }
 
-std::pair<Point, float> welzl(std::vector<Point>& points, std::vector<Point>& boundary)
+// Smallest circle enclosing a cell : a cell has about 6 neighbors, few enough to try the circles on 2 or 3 of them, without the shuffle and
+// the data dependent control flow of Welzl's algorithm. A circle on 2 points which encloses the others is on the farthest pair, and a
+// circle on 3 points which encloses the others and whose center is inside their triangle (no obtuse angle) is the smallest one, so the
+// search stops at the first one found. The containment test runs over the whole fixed size arrays without early exit, so the compiler
+// vectorizes it. Larger cells use welzl()
+template<int MaxPoints, typename T>
+std::pair<std::pair<T, T>, T> smallEnclosingCircle(std::span<std::pair<T, T>> points, std::uint32_t seed)
 {
-    std::pair<Point, float> circle = {{0.f, 0.f}, 0.f}; // Initialize the circle with center at origin and radius 0
+    const int n = static_cast<int>(points.size());
+    if (n > MaxPoints)
+        return welzl(points, seed);
+    if (n == 0)
+        return {{0, 0}, -1};
+
+    // Relative to the first point, the unused slots repeat it
+    const double                  originX = points[0].first;
+    const double                  originY = points[0].second;
+    std::array<double, MaxPoints> x{};
+    std::array<double, MaxPoints> y{};
+    for (int i = 0; i < n; ++i)
+    {
+        x[i] = points[i].first - originX;
+        y[i] = points[i].second - originY;
+    }
 
-    if (points.empty() || boundary.size() == 3)
+    auto encloses = [&](double cx, double cy, double r2) {
+        const double limit  = r2 * (1 + 1e-9);
+        bool         inside = true;
+        for (int k = 0; k < MaxPoints; ++k)
+            inside &= (x[k] - cx) * (x[k] - cx) + (y[k] - cy) * (y[k] - cy) <= limit;
+        return inside;
+    };
+    auto result = [&](double cx, double cy, double r2) {
+        return std::pair<std::pair<T, T>, T>{{static_cast<T>(originX + cx), static_cast<T>(originY + cy)}, static_cast<T>(std::sqrt(r2))};
+    };
+
+    // Two points : the diameter of the set. Duplicate and collinear points end here
+    int    farA     = 0;
+    int    farB     = 0;
+    double farthest = 0;
+    for (int i = 0; i < n; ++i)
     {
-        // Base case: if there are 3 or fewer points, return the boundary
-        return getCircle(boundary);
+        for (int j = i + 1; j < n; ++j)
+        {
+            const double d2 = (x[i] - x[j]) * (x[i] - x[j]) + (y[i] - y[j]) * (y[i] - y[j]);
+            if (d2 > farthest)
+            {
+                farthest = d2;
+                farA     = i;
+                farB     = j;
+            }
+        }
     }
-    else
+    const double middleX = (x[farA] + x[farB]) / 2;
+    const double middleY = (y[farA] + y[farB]) / 2;
+    if (encloses(middleX, middleY, farthest / 4))
+        return result(middleX, middleY, farthest / 4);
+
+    // Three points : the circumcircle of a triangle without obtuse angle, relative to its first vertex
+    auto tryTriangle = [&](int i, int j, int k, double& cx, double& cy, double& r2) {
+        const double bx = x[j] - x[i];
+        const double by = y[j] - y[i];
+        const double ax = x[k] - x[i];
+        const double ay = y[k] - y[i];
+        const double b2 = bx * bx + by * by;
+        const double a2 = ax * ax + ay * ay;
+        const double c2 = b2 + a2 - 2 * (bx * ax + by * ay); // |k - j|^2
+        const double d  = 2 * (bx * ay - by * ax);
+        if (b2 + a2 < c2 || b2 + c2 < a2 || a2 + c2 < b2 || std::abs(d) <= 1e-12 * std::max(b2, a2))
+            return false; // Obtuse or collinear
+        const double ux = (ay * b2 - by * a2) / d;
+        const double uy = (bx * a2 - ax * b2) / d;
+        cx              = x[i] + ux;
+        cy              = y[i] + uy;
+        r2              = ux * ux + uy * uy;
+        return encloses(cx, cy, r2);
+    };
+
+    // Most cells are round : the farthest pair with the point farthest from its middle is the usual support
+    int    farC               = 0;
+    double farthestFromMiddle = -1;
+    for (int k = 0; k < n; ++k)
     {
-        Point pt = points.back(); // Take the last point from the shuffled list
-        points.pop_back();        // Remove the point from the list
-        circle = welzl(points, boundary);
-        if (distance(circle.first, pt) > circle.second + 1e-6)
+        const double d2 = (x[k] - middleX) * (x[k] - middleX) + (y[k] - middleY) * (y[k] - middleY);
+        if (k != farA && k != farB && d2 > farthestFromMiddle)
         {
-            // If the point is inside the circle, return the current circle
-            boundary.push_back(pt);
-            circle = welzl(points, boundary);
-            boundary.pop_back(); // Remove the point from the boundary after recursion
+            farthestFromMiddle = d2;
+            farC               = k;
         }
-        points.push_back(pt); // Add the point back to the list after recursion
     }
+    double cx = 0;
+    double cy = 0;
+    double r2 = 0;
+    if (tryTriangle(farA, farB, farC, cx, cy, r2))
+        return result(cx, cy, r2);
+    for (int i = 0; i < n; ++i)
+        for (int j = i + 1; j < n; ++j)
+            for (int k = j + 1; k < n; ++k)
+                if (tryTriangle(i, j, k, cx, cy, r2))
+                    return result(cx, cy, r2);
 
-    return circle;
+    return welzl(points, seed); // Only reached through the rounding of a right angle
 }
+
+template std::pair<std::pair<float, float>, float>    welzl(std::span<std::pair<float, float>> points, std::uint32_t seed);
+template std::pair<std::pair<double, double>, double> welzl(std::span<std::pair<double, double>> points, std::uint32_t seed);
+
+template std::pair<std::pair<float, float>, float>    smallEnclosingCircle<welzlBruteForceSize>(std::span<std::pair<float, float>> points, std::uint32_t seed);
+template std::pair<std::pair<double, double>, double> smallEnclosingCircle<welzlBruteForceSize>(std::span<std::pair<double, double>> points, std::uint32_t seed);
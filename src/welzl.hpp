@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <utility>
+
+// Smallest circle enclosing the points, which are shuffled (from the seed) and reordered in place. A negative radius if there is no point
+template<typename T>
+std::pair<std::pair<T, T>, T> welzl(std::span<std::pair<T, T>> points, std::uint32_t seed);
+
+// Same circle, by brute force over the supports of 2 and 3 points up to MaxPoints points, welzl() above
+inline constexpr int welzlBruteForceSize = 8;
+template<int MaxPoints, typename T>
+std::pair<std::pair<T, T>, T> smallEnclosingCircle(std::span<std::pair<T, T>> points, std::uint32_t seed);
@@ -0,0 +1,107 @@
+#include <Eigen/Eigenvalues>
+#include <random>
+#include <vector>
+#include "boundingBox.hpp"
+#include "check.hpp"
+
+// The closed-form principal axis against Eigen's solver, and the box of the rotating calipers against the boxes along every direction
+// between two points, on random and degenerate point sets
+
+using Point = Point2<double>;
+
+static double boxArea(const std::array<Point, 4>& box)
+{
+    return (box[1] - box[0]).norm() * (box[3] - box[0]).norm();
+}
+
+// The points are inside of the box (a rectangle in order around it) up to the rounding
+static bool boxEncloses(const std::array<Point, 4>& box, std::span<const Point> points)
+{
+    const Point  axis   = box[1] - box[0];
+    const Point  normal = box[3] - box[0];
+    const double scale  = 1e-9 * (1 + axis.squaredNorm() + normal.squaredNorm());
+    for (const auto& p : points)
+    {
+        const double u = axis.dot(p - box[0]);
+        const double v = normal.dot(p - box[0]);
+        if (u < -scale || u > axis.squaredNorm() + scale || v < -scale || v > normal.squaredNorm() + scale)
+            return false;
+    }
+    return std::abs(axis.dot(normal)) <= 1e-9 * (1 + axis.norm() * normal.norm());
+}
+
+static void checkOrientedBox(std::span<const Point> points)
+{
+    const std::array<Point, 4> box = computeOrientedBoundingBox(points);
+    CHECK(boxEncloses(box, points));
+
+    // Same axis as the eigenvector of the largest eigenvalue of the covariance, when it is well defined
+    const Point     centroid   = computeCentroid(points);
+    Eigen::Matrix2d covariance = Eigen::Matrix2d::Zero();
+    for (const auto& p : points)
+        covariance += (p - centroid) * (p - centroid).transpose();
+    const Eigen::SelfAdjointEigenSolver<Eigen::Matrix2d> solver(covariance);
+    const Eigen::Vector2d                                eigenvalues = solver.eigenvalues();
+    if (eigenvalues(1) - eigenvalues(0) > 1e-6 * eigenvalues(1))
+    {
+        const Point axis = (box[1] - box[0]).normalized();
+        CHECK_CLOSE(std::abs(axis.dot(solver.eigenvectors().col(1))), 1, 1e-6);
+    }
+}
+
+static void checkMinimumAreaBox(std::span<const Point> points)
+{
+    std::vector<Point>         hull(points.size());
+    const std::array<Point, 4> box = computeMinimumAreaBox<double>(points, hull);
+    CHECK(boxEncloses(box, points));
+
+    // The smallest box has a side on an edge of the hull, so along the direction between two of the points
+    double best = std::numeric_limits<double>::max();
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        for (std::size_t j = i + 1; j < points.size(); ++j)
+        {
+            if (points[i] == points[j])
+                continue;
+            best = std::min(best, boxArea(boxAlongAxis(points, points[i], Point((points[j] - points[i]).normalized()))));
+        }
+    }
+    if (best != std::numeric_limits<double>::max())
+        CHECK(std::abs(boxArea(box) - best) <= 1e-9 * (1 + best));
+}
+
+int main()
+{
+    std::mt19937                           eng(13);
+    std::uniform_real_distribution<double> coordinate(-10, 10);
+    std::uniform_real_distribution<double> stretch(0.1, 5);
+    for (int query = 0; query < 2000; ++query)
+    {
+        const int          n = 3 + query % 20;
+        std::vector<Point> points;
+        const double       sx    = stretch(eng);
+        const double       sy    = stretch(eng);
+        const double       angle = coordinate(eng);
+        for (int i = 0; i < n; ++i)
+        {
+            // Anisotropic cloud, rotated : the principal axes are not the coordinate axes
+            const double x = sx * coordinate(eng);
+            const double y = sy * coordinate(eng);
+            points.emplace_back(std::cos(angle) * x - std::sin(angle) * y, std::sin(angle) * x + std::cos(angle) * y);
+        }
+        if (query % 10 == 0)
+            points.push_back(points[0]); // Repeated point
+        checkOrientedBox(points);
+        checkMinimumAreaBox(points);
+    }
+
+    // Collinear and identical points : flat boxes
+    const std::vector<Point> line{{0, 0}, {2, 1}, {-4, -2}, {1, 0.5}};
+    checkOrientedBox(line);
+    checkMinimumAreaBox(line);
+    const std::vector<Point> same(4, Point(1, -2));
+    CHECK(boxArea(computeOrientedBoundingBox<double>(same)) == 0);
+    checkMinimumAreaBox(same);
+
+    return checkResult();
+}
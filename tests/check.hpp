@@ -0,0 +1,40 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Minimal checks of the kernel tests : a failed check prints its location and the test returns an error at the end, so every failure of a
+// run is reported
+inline int checkFailures = 0;
+
+#define CHECK(condition)                                                                           \
+    do                                                                                             \
+    {                                                                                              \
+        if (!(condition))                                                                          \
+        {                                                                                          \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " << #condition << '\n'; \
+            ++checkFailures;                                                                       \
+        }                                                                                          \
+    } while (false)
+
+// a and b equal up to tolerance, relatively to the larger of them (absolutely below 1)
+#define CHECK_CLOSE(a, b, tolerance)                                                                                                      \
+    do                                                                                                                                    \
+    {                                                                                                                                     \
+        const double checkA = static_cast<double>(a);                                                                                     \
+        const double checkB = static_cast<double>(b);                                                                                     \
+        if (!(std::abs(checkA - checkB) <= (tolerance) * std::max({1., std::abs(checkA), std::abs(checkB)})))                            \
+        {                                                                                                                                 \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": " << #a << " = " << checkA << " and " << #b << " = " << checkB << " differ\n"; \
+            ++checkFailures;                                                                                                              \
+        }                                                                                                                                 \
+    } while (false)
+
+// Exit code of the test
+inline int checkResult()
+{
+    if (checkFailures > 0)
+        std::cerr << checkFailures << " check(s) failed\n";
+    return checkFailures == 0 ? 0 : 1;
+}
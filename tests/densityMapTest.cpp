@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "check.hpp"
+#include "densityMap.hpp"
+
+// The moments of polygons from their border (Green) against a sampling of the density, for the constant and the bilinear density, on a
+// random image and polygons partly outside of its frame
+
+using Point = std::pair<double, double>;
+
+// Abscissae where the horizontal line at y crosses the border of the polygon, sorted : the pairs are the pieces inside
+static void crossings(const std::vector<Point>& polygon, double y, std::vector<double>& xs)
+{
+    xs.clear();
+    for (std::size_t k = 0, l = polygon.size() - 1; k < polygon.size(); l = k++)
+    {
+        const Point& a = polygon[k];
+        const Point& b = polygon[l];
+        if ((a.second > y) != (b.second > y))
+            xs.push_back(a.first + (b.first - a.first) * (y - a.second) / (b.second - a.second));
+    }
+    std::sort(xs.begin(), xs.end());
+}
+
+static void checkMoments(const DensityMap<double>& density, const std::vector<Point>& polygon)
+{
+    DensityMap<double>::Moments grid;
+    for (std::size_t k = 0; k < polygon.size(); ++k)
+    {
+        const Point& a = polygon[k];
+        const Point& b = polygon[(k + 1) % polygon.size()];
+        density.addSegment(a.first, a.second, b.first, b.second, grid);
+    }
+    const DensityMap<double>::Moments exact = density.toWorld(grid);
+
+    // Midpoint samples on the pieces of rows inside the polygon, cut at the half units where the density has a kink or a jump (the pixels
+    // are of unit size from an integer corner), so the sampling is accurate to the square of its step
+    const double                step = 1. / 512;
+    std::vector<double>         xs;
+    DensityMap<double>::Moments sampled;
+    for (double y = -3 + step / 2; y < 6; y += step)
+    {
+        crossings(polygon, y, xs);
+        for (std::size_t k = 0; k + 1 < xs.size(); k += 2)
+        {
+            for (double start = xs[k]; start < xs[k + 1];)
+            {
+                const double end     = std::min(xs[k + 1], std::floor(start * 2 + 1) / 2);
+                const int    samples = static_cast<int>(std::ceil((end - start) / step));
+                const double dx      = (end - start) / samples;
+                for (int i = 0; i < samples; ++i)
+                {
+                    const double x   = start + (i + 0.5) * dx;
+                    const double rho = density.value(x, y) * dx * step;
+                    sampled.mass += rho;
+                    sampled.x += rho * x;
+                    sampled.y += rho * y;
+                    sampled.xx += rho * x * x;
+                    sampled.yy += rho * y * y;
+                }
+                start = end;
+            }
+        }
+    }
+
+    CHECK_CLOSE(exact.mass, sampled.mass, 1e-5);
+    CHECK_CLOSE(exact.x, sampled.x, 1e-5);
+    CHECK_CLOSE(exact.y, sampled.y, 1e-5);
+    CHECK_CLOSE(exact.xx, sampled.xx, 1e-5);
+    CHECK_CLOSE(exact.yy, sampled.yy, 1e-5);
+}
+
+int main()
+{
+    std::mt19937                       eng(3);
+    std::uniform_int_distribution<int> gray(0, 255);
+    const std::filesystem::path        path = std::filesystem::temp_directory_path() / "densityMapTest.pgm";
+    {
+        std::ofstream file(path);
+        file << "P2\n7 5\n255\n";
+        for (int i = 0; i < 7 * 5; ++i)
+            file << gray(eng) << ' ';
+    }
+
+    const std::vector<std::vector<Point>> polygons{
+        {{-3, -0.5}, {4.3, -2}, {5.6, 4.7}, {-1.2, 2.2}}, // Over every border of the frame
+        {{-0.7, 0.2}, {3.1, 0.6}, {2.4, 3.3}},            // Inside
+        {{1, -1}, {6, -1}, {6, 4}, {1, 4}},               // Over the right half
+        {{0, 1.5}, {-1.5, 3.8}, {-3, 1}},                 // Over the left border
+    };
+    for (const bool bilinear : {false, true})
+    {
+        DensityMap<double> density;
+        density.setBilinear(bilinear);
+        CHECK(density.load(path.string()));
+        density.setFrame(-2, -1, 5, 4);
+        CHECK(density.value(-2.01, 1.5) == 0);
+        CHECK(density.value(5.01, 1.5) == 0);
+        for (const auto& polygon : polygons)
+            checkMoments(density, polygon);
+    }
+
+    std::filesystem::remove(path);
+    return checkResult();
+}
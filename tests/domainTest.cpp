@@ -0,0 +1,170 @@
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <vector>
+#include "check.hpp"
+#include "domainClipping.hpp"
+
+// The queries of a domain with holes against a scan of its rings, and the clipping of convex polygons against a sampling of the domain
+
+using Point = std::pair<double, double>;
+
+// Star shaped outer ring (not convex) with a square hole and a triangular hole
+static Domain<double> makeDomain()
+{
+    std::vector<Point> star;
+    for (int i = 0; i < 14; ++i)
+    {
+        const double angle  = 2 * std::numbers::pi * i / 14;
+        const double radius = i % 2 == 0 ? 10 : 6.5;
+        star.emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+    }
+    Domain<double> domain;
+    domain.setRings({star, {{-2, -2}, {-2, 2}, {2, 2}, {2, -2}}, {{3, -5}, {5.5, -4.5}, {4, -2.5}}});
+    return domain;
+}
+
+// Even-odd rule over every edge of the rings
+static bool bruteContains(const Domain<double>& domain, const Point& p)
+{
+    bool inside = false;
+    for (const auto& edge : domain.edges())
+    {
+        if ((edge.a.second > p.second) != (edge.b.second > p.second))
+        {
+            const double x = edge.a.first + (p.second - edge.a.second) / (edge.b.second - edge.a.second) * (edge.b.first - edge.a.first);
+            if (x > p.first)
+                inside = !inside;
+        }
+    }
+    return inside;
+}
+
+static Point lerp(const Point& a, const Point& b, double t)
+{
+    return {a.first + t * (b.first - a.first), a.second + t * (b.second - a.second)};
+}
+
+static void checkContains(const Domain<double>& domain, std::mt19937& eng)
+{
+    std::uniform_real_distribution<double> coordinate(-11, 11);
+    for (int query = 0; query < 20000; ++query)
+    {
+        const Point p(coordinate(eng), coordinate(eng));
+        CHECK(domain.contains(p) == bruteContains(domain, p));
+    }
+}
+
+// The intervals are sorted, disjoint, and a sample along the segment is inside exactly when it is in one of them
+static void checkInsideIntervals(const Domain<double>& domain, std::mt19937& eng)
+{
+    std::uniform_real_distribution<double> coordinate(-12, 12);
+    std::vector<double>                    intervals;
+    for (int query = 0; query < 300; ++query)
+    {
+        const Point a(coordinate(eng), coordinate(eng));
+        const Point b(coordinate(eng), coordinate(eng));
+        intervals.clear();
+        domain.insideIntervals(a, b, intervals);
+        CHECK(intervals.size() % 2 == 0);
+        for (std::size_t k = 1; k < intervals.size(); ++k)
+            CHECK(intervals[k - 1] <= intervals[k]);
+
+        for (int sample = 0; sample <= 500; ++sample)
+        {
+            const double t          = (sample + 0.5) / 501;
+            bool         inInterval = false;
+            bool         nearCut    = false;
+            for (std::size_t k = 0; k < intervals.size(); k += 2)
+            {
+                inInterval |= t > intervals[k] && t < intervals[k + 1];
+                nearCut |= std::abs(t - intervals[k]) < 1e-9 || std::abs(t - intervals[k + 1]) < 1e-9;
+            }
+            if (!nearCut)
+                CHECK(inInterval == bruteContains(domain, lerp(a, b, t)));
+        }
+    }
+}
+
+// Area of the intersection from its border (Green), against the fraction of a fine grid of the box of the polygon inside both
+static void checkClipping(const Domain<double>& domain, std::mt19937& eng)
+{
+    std::uniform_real_distribution<double> center(-11, 11);
+    std::uniform_real_distribution<double> size(0.5, 6);
+    std::uniform_real_distribution<double> angle(0, 2 * std::numbers::pi);
+    std::vector<int>                       candidates;
+    std::vector<double>                    cuts;
+    std::vector<Point>                     out;
+    for (int query = 0; query < 200; ++query)
+    {
+        // Convex polygon : points on an ellipse at increasing angles
+        const int           n = 3 + query % 6;
+        std::vector<double> angles(n);
+        for (double& a : angles)
+            a = angle(eng);
+        std::sort(angles.begin(), angles.end());
+        const Point        c(center(eng), center(eng));
+        const double       rx = size(eng);
+        const double       ry = size(eng);
+        std::vector<Point> polygon;
+        for (const double a : angles)
+            polygon.emplace_back(c.first + rx * std::cos(a), c.second + ry * std::sin(a));
+
+        out.clear();
+        clipConvexPolygonToDomain<double>(polygon, domain, candidates, cuts, out);
+        CHECK(out.size() % 2 == 0);
+        double area = 0;
+        for (std::size_t k = 0; k + 1 < out.size(); k += 2)
+            area += cross(out[k], out[k + 1]) / 2;
+
+        // Midpoint samples of a grid over the box of the polygon
+        double minX = polygon[0].first, maxX = minX, minY = polygon[0].second, maxY = minY;
+        for (const auto& p : polygon)
+        {
+            minX = std::min(minX, p.first);
+            maxX = std::max(maxX, p.first);
+            minY = std::min(minY, p.second);
+            maxY = std::max(maxY, p.second);
+        }
+        const int    resolution = 400;
+        const double dx         = (maxX - minX) / resolution;
+        const double dy         = (maxY - minY) / resolution;
+        int          hits       = 0;
+        for (int j = 0; j < resolution; ++j)
+        {
+            for (int i = 0; i < resolution; ++i)
+            {
+                const Point p(minX + (i + 0.5) * dx, minY + (j + 0.5) * dy);
+                bool        inPolygon = true;
+                for (int k = 0; k < n; ++k)
+                    inPolygon &= cross(Point(polygon[(k + 1) % n].first - polygon[k].first, polygon[(k + 1) % n].second - polygon[k].second),
+                                       Point(p.first - polygon[k].first, p.second - polygon[k].second)) >= 0;
+                hits += inPolygon && bruteContains(domain, p);
+            }
+        }
+        const double sampled = hits * dx * dy;
+
+        // The error of the sampling is about the perimeter of the intersection times the step of the grid
+        const double tolerance = 2 * (dx + dy) * (rx + ry);
+        CHECK(std::abs(area - sampled) <= tolerance);
+    }
+
+    // A polygon around the whole domain gives back its area
+    const std::vector<Point> around{{-20, -20}, {20, -20}, {20, 20}, {-20, 20}};
+    out.clear();
+    clipConvexPolygonToDomain<double>(around, domain, candidates, cuts, out);
+    double area = 0;
+    for (std::size_t k = 0; k + 1 < out.size(); k += 2)
+        area += cross(out[k], out[k + 1]) / 2;
+    CHECK_CLOSE(area, domain.area(), 1e-12);
+}
+
+int main()
+{
+    const Domain<double> domain = makeDomain();
+    std::mt19937         eng(7);
+    checkContains(domain, eng);
+    checkInsideIntervals(domain, eng);
+    checkClipping(domain, eng);
+    return checkResult();
+}
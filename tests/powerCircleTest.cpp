@@ -0,0 +1,84 @@
+#include <random>
+#include "check.hpp"
+#include "Delaunay/include/triangle.h"
+
+// The power test of the regular triangulation against the sign of the lifted determinant in long double, its reduction to the circumcircle
+// test without weights, and the flat triangles
+
+// Sign of the power of v relative to the orthocircle of (a, b, c), negative when v is in conflict : the points are lifted to x^2 + y^2 - w
+// and the orientation of the lifted tetrahedron, scaled by the orientation of the triangle, gives the side of v
+template<typename T>
+static long double liftedPower(const dt::Vector2<T>& a, const dt::Vector2<T>& b, const dt::Vector2<T>& c, const dt::Vector2<T>& v, T wa, T wb,
+                               T wc, T wv)
+{
+    auto lift = [&](const dt::Vector2<T>& p, T w, long double row[3]) {
+        row[0] = static_cast<long double>(p.x) - v.x;
+        row[1] = static_cast<long double>(p.y) - v.y;
+        row[2] = static_cast<long double>(p.x) * p.x + static_cast<long double>(p.y) * p.y - w
+               - (static_cast<long double>(v.x) * v.x + static_cast<long double>(v.y) * v.y - wv);
+    };
+    long double ra[3], rb[3], rc[3];
+    lift(a, wa, ra);
+    lift(b, wb, rb);
+    lift(c, wc, rc);
+    const long double determinant = ra[0] * (rb[1] * rc[2] - rb[2] * rc[1]) - ra[1] * (rb[0] * rc[2] - rb[2] * rc[0])
+                                  + ra[2] * (rb[0] * rc[1] - rb[1] * rc[0]);
+    const long double orientation = (static_cast<long double>(b.x) - a.x) * (static_cast<long double>(c.y) - a.y)
+                                  - (static_cast<long double>(b.y) - a.y) * (static_cast<long double>(c.x) - a.x);
+    return orientation > 0 ? -determinant : determinant;
+}
+
+template<typename T>
+static void checkPowerTest(std::mt19937& eng)
+{
+    using Vertex = dt::Vector2<T>;
+    std::uniform_real_distribution<T> coordinate(-100, 100);
+    std::uniform_real_distribution<T> weight(0, 400);
+    int                               inConflict = 0;
+    for (int query = 0; query < 20000; ++query)
+    {
+        const Vertex          a(coordinate(eng), coordinate(eng));
+        const Vertex          b(coordinate(eng), coordinate(eng));
+        const Vertex          c(coordinate(eng), coordinate(eng));
+        const Vertex          v(coordinate(eng), coordinate(eng));
+        const dt::Triangle<T> triangle(a, b, c);
+        const T               wa = weight(eng);
+        const T               wb = weight(eng);
+        const T               wc = weight(eng);
+        const T               wv = weight(eng);
+
+        // Skip the near ties, where the rounding of the orthocenter decides
+        const long double power = liftedPower(a, b, c, v, wa, wb, wc, wv);
+        const long double scale = 1e-3L * 200 * 200 * 200 * 200;
+        if (std::abs(power) > scale)
+        {
+            CHECK(triangle.powerCircleContains(v, wa, wb, wc, wv) == (power < 0));
+            inConflict += power < 0;
+        }
+
+        const long double circle = liftedPower<T>(a, b, c, v, 0, 0, 0, 0);
+        if (std::abs(circle) > scale)
+        {
+            CHECK(triangle.powerCircleContains(v, 0, 0, 0, 0) == (circle < 0));
+            CHECK(triangle.powerCircleContains(v, 0, 0, 0, 0) == triangle.circumCircleContains(v));
+        }
+    }
+    CHECK(inConflict > 1000); // Both answers are tested
+
+    // Flat triangles : collinear or repeated vertices
+    const Vertex origin(0, 0);
+    const Vertex diagonal(1, 1);
+    const Vertex farDiagonal(3, 3);
+    const Vertex inside(2, 2.5);
+    CHECK(!dt::Triangle<T>(origin, diagonal, farDiagonal).powerCircleContains(inside, 0, 0, 0, 0));
+    CHECK(!dt::Triangle<T>(origin, farDiagonal, diagonal).powerCircleContains(diagonal, 1, 2, 3, 10));
+    CHECK(!dt::Triangle<T>(origin, origin, diagonal).powerCircleContains(inside, 0, 0, 0, 0));
+}
+
+int main()
+{
+    std::mt19937 eng(11);
+    checkPowerTest<float>(eng);
+    checkPowerTest<double>(eng);
+    return checkResult();
+}
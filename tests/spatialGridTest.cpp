@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "check.hpp"
+#include "spatialGrid.hpp"
+
+// The queries of the grid against a scan of every point, on a cloud which is then moved (partly outside of the box of the grid)
+
+using Points = BasicPointList<double>;
+
+static double distance2(const Points& points, int idx, const std::pair<double, double>& p)
+{
+    const double dx = points.x[idx] - p.first;
+    const double dy = points.y[idx] - p.second;
+    return dx * dx + dy * dy;
+}
+
+// Squared distances of the k closest points to p, by increasing distance (the indices may differ on ties)
+static std::vector<double> bruteKNearest(const Points& points, const std::pair<double, double>& p, int k, int exclude)
+{
+    std::vector<double> distances;
+    for (int i = 0; i < static_cast<int>(points.size()); ++i)
+        if (i != exclude)
+            distances.push_back(distance2(points, i, p));
+    std::sort(distances.begin(), distances.end());
+    distances.resize(std::min<std::size_t>(k, distances.size()));
+    return distances;
+}
+
+static void checkQueries(const SpatialGrid<double>& grid, const Points& points, std::mt19937& eng)
+{
+    std::uniform_real_distribution<double> coordinate(-12, 12);
+    std::vector<int>                       result;
+    for (int query = 0; query < 300; ++query)
+    {
+        const std::pair<double, double> p(coordinate(eng), coordinate(eng));
+        const int                       exclude = query % 3 == 0 ? query % static_cast<int>(points.size()) : -1;
+
+        // nearest
+        const int                 nearest = grid.nearest(points, p, exclude);
+        const std::vector<double> closest = bruteKNearest(points, p, 1, exclude);
+        CHECK(nearest != -1 && nearest != exclude);
+        CHECK_CLOSE(distance2(points, nearest, p), closest[0], 1e-12);
+
+        // kNearest, sorted by distance
+        for (const int k : {1, 6, 17})
+        {
+            grid.kNearest(points, p, k, result, exclude);
+            const std::vector<double> expected = bruteKNearest(points, p, k, exclude);
+            CHECK(result.size() == expected.size());
+            for (std::size_t j = 0; j < std::min(result.size(), expected.size()); ++j)
+                CHECK_CLOSE(distance2(points, result[j], p), expected[j], 1e-12);
+        }
+
+        // radius, as a set
+        const double r = 0.3 + query % 5;
+        grid.radius(points, p, r, result);
+        std::sort(result.begin(), result.end());
+        std::vector<int> expected;
+        for (int i = 0; i < static_cast<int>(points.size()); ++i)
+            if (distance2(points, i, p) <= r * r)
+                expected.push_back(i);
+        CHECK(result == expected);
+    }
+
+    // exactMatch finds every point at its own position
+    for (int i = 0; i < static_cast<int>(points.size()); i += 7)
+    {
+        grid.exactMatches(points, points[i], 1e-9, result);
+        CHECK(std::find(result.begin(), result.end(), i) != result.end());
+    }
+}
+
+int main()
+{
+    std::mt19937                           eng(7);
+    std::uniform_real_distribution<double> coordinate(-10, 10);
+    std::normal_distribution<double>       cluster(3, 0.05);
+
+    Points points;
+    for (int i = 0; i < 1500; ++i)
+        points.emplace_back(coordinate(eng), coordinate(eng));
+    for (int i = 0; i < 300; ++i)
+        points.emplace_back(cluster(eng), cluster(eng)); // Many points in a few cells
+    for (int i = 0; i < 20; ++i)
+        points.emplace_back(-4, 5); // Duplicates
+
+    SpatialGrid<double> grid;
+    grid.build(points);
+    CHECK(grid.isBuiltFor(points));
+    checkQueries(grid, points, eng);
+
+    // Moves, some of them outside of the box of the grid
+    std::uniform_real_distribution<double> wider(-14, 14);
+    for (int i = 0; i < static_cast<int>(points.size()); i += 3)
+    {
+        points.set(i, {wider(eng), wider(eng)});
+        grid.update(points, i);
+    }
+    checkQueries(grid, points, eng);
+
+    // A new point changes the generation : the grid is stale
+    points.emplace_back(0, 0);
+    CHECK(!grid.isBuiltFor(points));
+    grid.clear();
+    CHECK(!grid.isBuiltFor(points));
+    grid.build(points);
+    CHECK(grid.isBuiltFor(points));
+
+    return checkResult();
+}
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <random>
+#include <vector>
+#include "check.hpp"
+#include "welzl.hpp"
+
+// The smallest enclosing circle of Welzl's algorithm and of the fixed size search against the smallest of the circles on 2 and 3 of the
+// points which enclose all of them, on random, cocircular, collinear and repeated points
+
+using Point = std::pair<double, double>;
+
+struct Circle {
+    double x = 0;
+    double y = 0;
+    double r = -1;
+};
+
+static bool encloses(const Circle& circle, std::span<const Point> points)
+{
+    for (const auto& p : points)
+        if (std::hypot(p.first - circle.x, p.second - circle.y) > circle.r * (1 + 1e-9) + 1e-12)
+            return false;
+    return true;
+}
+
+static Circle bruteForceCircle(std::span<const Point> points)
+{
+    const int n    = static_cast<int>(points.size());
+    Circle    best = {points[0].first, points[0].second, 0};
+    if (encloses(best, points))
+        return best;
+    best.r = std::numeric_limits<double>::max();
+
+    auto consider = [&](const Circle& circle) {
+        if (circle.r < best.r && encloses(circle, points))
+            best = circle;
+    };
+    for (int i = 0; i < n; ++i)
+    {
+        for (int j = i + 1; j < n; ++j)
+        {
+            const Point& a = points[i];
+            const Point& b = points[j];
+            consider({(a.first + b.first) / 2, (a.second + b.second) / 2, std::hypot(a.first - b.first, a.second - b.second) / 2});
+            for (int k = j + 1; k < n; ++k)
+            {
+                const Point& c  = points[k];
+                const double bx = b.first - a.first;
+                const double by = b.second - a.second;
+                const double cx = c.first - a.first;
+                const double cy = c.second - a.second;
+                const double d  = 2 * (bx * cy - by * cx);
+                if (d == 0)
+                    continue;
+                const double ux = (cy * (bx * bx + by * by) - by * (cx * cx + cy * cy)) / d;
+                const double uy = (bx * (cx * cx + cy * cy) - cx * (bx * bx + by * by)) / d;
+                consider({a.first + ux, a.second + uy, std::hypot(ux, uy)});
+            }
+        }
+    }
+    return best;
+}
+
+// Both algorithms on a copy of the points (they reorder them), compared with the brute force
+static void checkCircle(const std::vector<Point>& points, std::uint32_t seed)
+{
+    const Circle expected = bruteForceCircle(points);
+
+    for (const bool fixedSize : {false, true})
+    {
+        std::vector<Point>     copy = points;
+        const std::span<Point> span(copy);
+        const auto [center, r]  = fixedSize ? smallEnclosingCircle<welzlBruteForceSize>(span, seed) : welzl(span, seed);
+        const Circle            circle{center.first, center.second, r};
+        CHECK(encloses(circle, points));
+        CHECK_CLOSE(circle.r, expected.r, 1e-9);
+    }
+}
+
+int main()
+{
+    std::mt19937                           eng(5);
+    std::uniform_real_distribution<double> coordinate(-10, 10);
+    std::uniform_real_distribution<double> angle(0, 2 * std::numbers::pi);
+    for (int query = 0; query < 2000; ++query)
+    {
+        const int          n = 1 + query % 14; // Both sides of welzlBruteForceSize
+        std::vector<Point> points;
+        switch (query / 14 % 4)
+        {
+            case 0: // Random
+                for (int i = 0; i < n; ++i)
+                    points.emplace_back(coordinate(eng), coordinate(eng));
+                break;
+            case 1: // Around a circle, like the vertices of a cell
+                for (int i = 0; i < n; ++i)
+                {
+                    const double a = angle(eng);
+                    points.emplace_back(3 + 2 * std::cos(a), -1 + 2 * std::sin(a));
+                }
+                break;
+            case 2: // On a line
+                for (int i = 0; i < n; ++i)
+                {
+                    const double t = coordinate(eng);
+                    points.emplace_back(1 + t, 2 - 0.5 * t);
+                }
+                break;
+            default: // Repeated points
+                for (int i = 0; i < n; ++i)
+                    points.emplace_back(i % 3, i % 3 == 0 ? 1. : -2.);
+                break;
+        }
+        checkCircle(points, query);
+    }
+
+    // Single and identical points : a null radius
+    std::vector<Point> same(5, Point(4, -3));
+    const auto [center, r] = welzl(std::span<Point>(same), 0);
+    CHECK(center == Point(4, -3) && r == 0);
+    CHECK(welzl(std::span<Point>(), 0).second < 0);
+
+    return checkResult();
+}